@@ -1,63 +1,196 @@
 #pragma once
 #include <queue>
+#include <vector>
+#include <unordered_set>
+#include <mutex>
 #include <condition_variable>
 #include <glm/glm.hpp>
 #include <atomic>
-#include <vertex.h>
+#include <voxelVertex.h>
+#include "chunkData.hpp"
 #include <algorithm>
 
+struct ChunkHasher
+{
+  size_t operator()(const glm::ivec3 &v) const
+  {
+    return std::hash<int>()(v.x) ^ (std::hash<int>()(v.y) << 1) ^ (std::hash<int>()(v.z) << 2);
+  }
+};
+
+// chunk requests handed out nearest to the focus chunk first, requests that leave the radius are dropped
 class ChunkQueue
 {
 public:
-  void push(const glm::ivec3 &item)
+  // returns false if the chunk is already queued
+  bool push(const glm::ivec3 &item)
   {
     std::lock_guard<std::mutex> lock(mtx);
-    queue.push_front(item);
-    cv.notify_one();
+    if (!queued.insert(item).second)
+      return false;
+    heap.push_back({distanceSquared(item), item});
+    std::push_heap(heap.begin(), heap.end(), farther);
+    return true;
   }
 
   bool pop(glm::ivec3 &item)
   {
-    std::unique_lock<std::mutex> lock(mtx);
-    if (queue.empty())
+    std::lock_guard<std::mutex> lock(mtx);
+    if (heap.empty())
       return false;
-    item = std::move(queue.front());
-    queue.pop_front();
+    std::pop_heap(heap.begin(), heap.end(), farther);
+    item = heap.back().position;
+    heap.pop_back();
+    queued.erase(item);
     return true;
   }
 
+  // reorders the queue around a new focus chunk and cancels requests more than radius chunks away
+  void setFocus(const glm::ivec3 &chunkPos, int radius)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (chunkPos == focus && radius == focusRadius)
+      return;
+    focus = chunkPos;
+    focusRadius = radius;
+
+    int limit = radius * ChunkData::chunkSize;
+    heap.erase(std::remove_if(heap.begin(), heap.end(), [&](const Request &request)
+                              {
+                                glm::ivec3 offset = glm::abs(request.position - focus);
+                                if (offset.x <= limit && offset.z <= limit)
+                                  return false;
+                                queued.erase(request.position);
+                                return true; }),
+               heap.end());
+    for (Request &request : heap)
+    {
+      request.distance = distanceSquared(request.position);
+    }
+    std::make_heap(heap.begin(), heap.end(), farther);
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    heap.clear();
+    queued.clear();
+  }
+
   bool empty() const
   {
     std::lock_guard<std::mutex> lock(mtx);
-    return queue.empty();
+    return heap.empty();
   }
 
   bool has(const glm::ivec3 &item) const
   {
     std::lock_guard<std::mutex> lock(mtx);
-    return std::find(queue.begin(), queue.end(), item) != queue.end();
+    return queued.count(item) != 0;
   }
 
 private:
+  struct Request
+  {
+    int distance;
+    glm::ivec3 position;
+  };
+
   mutable std::mutex mtx;
-  std::deque<glm::ivec3> queue;
-  std::condition_variable cv;
+  std::vector<Request> heap;
+  std::unordered_set<glm::ivec3, ChunkHasher> queued;
+  glm::ivec3 focus = glm::ivec3(0);
+  int focusRadius = -1;
+
+  static bool farther(const Request &a, const Request &b)
+  {
+    return a.distance > b.distance;
+  }
+
+  int distanceSquared(const glm::ivec3 &item) const
+  {
+    glm::ivec3 offset = (item - focus) / ChunkData::chunkSize;
+    return offset.x * offset.x + offset.z * offset.z;
+  }
+};
+
+// mesh of one 16³ section, positions stay relative to the chunk
+struct SectionMeshData
+{
+  int section;
+  std::vector<VoxelVertex> vertices;
+  std::vector<VoxelVertex> translucentVertices;
+
+  explicit SectionMeshData(int section) : section(section)
+  {
+  }
 };
 
+// new meshes for the remeshed sections of a chunk, an empty section mesh removes the old one.
+// Move only, the vertex buffers travel from the worker to the upload without a copy
 struct CompletedData
 {
   glm::ivec3 position;
-  std::vector<Vertex> vertices;
-  std::vector<uint32_t> indices;
+  std::vector<SectionMeshData> sections;
+
+  CompletedData() = default;
+  CompletedData(const glm::ivec3 &position, std::vector<SectionMeshData> &&sections) : position(position), sections(std::move(sections))
+  {
+  }
+
+  CompletedData(const CompletedData &) = delete;
+  CompletedData &operator=(const CompletedData &) = delete;
+  CompletedData(CompletedData &&) = default;
+  CompletedData &operator=(CompletedData &&) = default;
+};
+
+// section buffers handed back after upload, workers reuse their capacity for the next meshes
+class MeshBufferPool
+{
+public:
+  SectionMeshData acquire(int section)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (buffers.empty())
+      return SectionMeshData(section);
+
+    SectionMeshData data = std::move(buffers.back());
+    buffers.pop_back();
+    data.section = section;
+    return data;
+  }
+
+  void release(std::vector<SectionMeshData> &&sections)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (SectionMeshData &data : sections)
+    {
+      if (buffers.size() >= maxBuffers)
+        break;
+      if (data.vertices.capacity() == 0 && data.translucentVertices.capacity() == 0)
+        continue;
+
+      data.vertices.clear();
+      data.translucentVertices.clear();
+      buffers.push_back(std::move(data));
+    }
+    sections.clear();
+  }
+
+private:
+  static const size_t maxBuffers = 512;
+
+  std::mutex mtx;
+  std::vector<SectionMeshData> buffers;
 };
 
 class CompletedQueue
 {
 public:
-  void push(const CompletedData &item)
+  void push(CompletedData &&item)
   {
     std::lock_guard<std::mutex> lock(mtx);
-    queue.push(item);
+    queue.push(std::move(item));
     cv.notify_one();
   }
 
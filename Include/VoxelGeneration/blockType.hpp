@@ -1,6 +1,7 @@
 #ifndef BLOCK_TYPE_H
 #define BLOCK_TYPE_H
-enum class BlockType
+#include <cstdint>
+enum class BlockType : uint8_t
 {
   Nothing,
   Air,
@@ -0,0 +1,20 @@
+#pragma once
+#include "chunkData.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Compact encoding of the blocks of a chunk, the warm tier of ChunkResidency keeps unloaded chunks in
+// it. Every column (x, z), in the order x * chunkSize + z, becomes runs of equal blocks from the bottom
+// up, one byte block id and one byte run length - 1 each. Neighboring columns repeat almost the same
+// runs, so the runs are then compressed with lzCompress.
+void encodeChunk(const ChunkData &chunk, std::vector<uint8_t> &out);
+// false if the bytes are malformed or hold an unknown block type, the chunk is then left partially overwritten
+bool decodeChunk(const uint8_t *data, size_t size, ChunkData &chunk);
+
+// Byte oriented LZ77 in the style of LZ4: the decompressed size, then sequences of a token (literal
+// count << 4 | match length - 4, 15 continues in extra bytes), the literals and a 2 byte match offset.
+// The last sequence has literals only.
+void lzCompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+// false if the bytes are malformed
+bool lzDecompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
@@ -1,6 +1,7 @@
 #ifndef CHUNK_DATA_H
 #define CHUNK_DATA_H
 #include "blockType.hpp"
+#include "paletteStorage.hpp"
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -10,19 +11,25 @@ class ChunkData
 public:
   static const int chunkSize = 16;
   static const int chunkHeight = 256;
-  BlockType blocks[chunkSize * chunkSize * chunkHeight];
+  static const int sectionHeight = 16;
+  static const int sectionCount = chunkHeight / sectionHeight;
+  static const uint16_t allSections = 0xFFFF;
+  std::vector<PaletteStorage> sections;
 
   glm::ivec3 worldPosition;
-  bool modifiedChunk = true;
+  // one bit per section that has to be remeshed
+  uint16_t dirtySections = allSections;
+  // mesh resolution, 0 is full resolution and level n merges 2^n blocks per axis
+  int lodLevel = 0;
   ChunkData(const ChunkData &other) = default;
   ChunkData(ChunkData &&other) noexcept = default;
   ChunkData &operator=(const ChunkData &other) = default;
   ChunkData &operator=(ChunkData &&other) noexcept = default;
   ChunkData(glm::ivec3 worldPosition);
 
-  inline int toIndex(int x, int y, int z) const
+  inline int toSectionIndex(int x, int y, int z) const
   {
-    return x + chunkSize * (y + chunkHeight * z);
+    return x + chunkSize * ((y & (sectionHeight - 1)) + sectionHeight * z);
   }
 
   BlockType getBlock(int x, int y, int z) const
@@ -30,18 +37,57 @@ public:
     if (x < 0 || x >= chunkSize || y < 0 || y >= chunkHeight || z < 0 || z >= chunkSize)
       return BlockType::Nothing;
 
-    int idx = toIndex(x, y, z);
-    return blocks[idx];
+    return sections[y / sectionHeight].get(toSectionIndex(x, y, z));
   }
 
   int setBlock(int x, int y, int z, BlockType type)
   {
     if (x < 0 || x >= chunkSize || y < 0 || y >= chunkHeight || z < 0 || z >= chunkSize)
       return -1;
-    blocks[toIndex(x, y, z)] = type;
-    modifiedChunk = true;
+    sections[y / sectionHeight].set(toSectionIndex(x, y, z), type);
+    markDirty(y);
     return 0;
   }
+
+  // marks the section holding y, and the section above or below when y is on its border
+  void markDirty(int y)
+  {
+    dirtySections |= sectionsTouching(y);
+  }
+
+  static uint16_t sectionsTouching(int y)
+  {
+    int section = y / sectionHeight;
+    uint16_t mask = uint16_t(1u << section);
+    if (y % sectionHeight == 0 && section > 0)
+      mask |= uint16_t(1u << (section - 1));
+    if (y % sectionHeight == sectionHeight - 1 && section < sectionCount - 1)
+      mask |= uint16_t(1u << (section + 1));
+    return mask;
+  }
+
+  // true if the whole section is Air or Nothing
+  bool isSectionEmpty(int section) const
+  {
+    const PaletteStorage &storage = sections[section];
+    return storage.isUniform() && (storage.getUniformBlock() == BlockType::Air || storage.getUniformBlock() == BlockType::Nothing);
+  }
+
+  // bytes of the chunk and its block storage
+  size_t memoryUsage() const
+  {
+    size_t bytes = sizeof(ChunkData);
+    for (const PaletteStorage &section : sections)
+    {
+      bytes += sizeof(PaletteStorage) + section.memoryUsage();
+    }
+    return bytes;
+  }
+
+  void fill(BlockType type);
+
+  // collapses sections that ended up holding a single block type
+  void compact();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// one positional read or write of a file opened by an IOBackend. complete runs on the thread calling
+// IOBackend::complete with the number of bytes transferred, or a negative value on failure
+struct IORequest
+{
+  int file;
+  bool write;
+  uint64_t offset;
+  uint8_t *data;
+  uint32_t size;
+  std::function<void(int64_t result)> complete;
+};
+
+// Batched file reads and writes, driven by a single I/O thread. Only wake may be called from other threads
+class IOBackend
+{
+public:
+  virtual ~IOBackend() = default;
+
+  virtual const char *name() const = 0;
+
+  // opens or creates the file for reading and writing, -1 on failure
+  virtual int open(const std::string &path) = 0;
+  virtual void close(int file) = 0;
+  virtual int64_t fileSize(int file) = 0;
+  // blocking, only for the few bytes needed before any request on the file can be built
+  virtual bool readNow(int file, uint64_t offset, uint8_t *data, uint32_t size) = 0;
+  virtual bool writeNow(int file, uint64_t offset, const uint8_t *data, uint32_t size) = 0;
+
+  // starts the requests and empties the vector, they complete in any order
+  virtual void submit(std::vector<IORequest> &requests) = 0;
+  // runs the callbacks of finished requests. With wait it first blocks until a request finished or
+  // wake was called, also when nothing is in flight
+  virtual void complete(bool wait) = 0;
+  virtual void wake() = 0;
+};
+
+// io_uring on Linux, nullptr where it is not built in or the kernel refuses to set up a ring
+std::unique_ptr<IOBackend> createUringBackend(unsigned queueDepth);
+// blocking calls on threads of its own, works everywhere
+std::unique_ptr<IOBackend> createThreadPoolBackend(unsigned threadCount);
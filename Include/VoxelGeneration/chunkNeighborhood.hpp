@@ -0,0 +1,54 @@
+#ifndef CHUNK_NEIGHBORHOOD_H
+#define CHUNK_NEIGHBORHOOD_H
+#include "chunkData.hpp"
+#include <vector>
+#include <glm/glm.hpp>
+
+// Copy of one chunk plus a one block border taken from its neighbors, so meshing
+// can run without touching World or its locks. Coordinates are chunk local and
+// range from -1 to chunkSize / chunkHeight inclusive. Blocks of missing neighbors
+// (and below / above the world) read as Nothing.
+class ChunkNeighborhood
+{
+public:
+  static const int sizeX = ChunkData::chunkSize + 2;
+  static const int sizeY = ChunkData::chunkHeight + 2;
+  static const int sizeZ = ChunkData::chunkSize + 2;
+  static const int strideX = 1;
+  static const int strideZ = sizeX;
+  static const int strideY = sizeX * sizeZ;
+
+  glm::ivec3 worldPosition;
+  std::vector<BlockType> blocks;
+  bool sectionEmpty[ChunkData::sectionCount];
+  // lodLevel of the center chunk
+  int lodLevel;
+
+  ChunkNeighborhood() : blocks(sizeX * sizeY * sizeZ, BlockType::Nothing)
+  {
+    clear(glm::ivec3(0));
+  }
+
+  inline int toIndex(int x, int y, int z) const
+  {
+    return (x + 1) * strideX + (z + 1) * strideZ + (y + 1) * strideY;
+  }
+
+  BlockType getBlock(int x, int y, int z) const
+  {
+    return blocks[toIndex(x, y, z)];
+  }
+
+  static const int blockTypeCount = static_cast<int>(BlockType::Tree_Leafes_Solid) + 1;
+
+  // copies the given area of a chunk into the buffer, (x, z) in chunk local coordinates of the center chunk
+  void copyFrom(const ChunkData &chunk, int srcX0, int srcZ0, int dstX0, int dstZ0, int width, int depth);
+  // same as copyFrom, but every 2^lodLevel cell of the chunk reads as its majority block, the way the
+  // chunk is drawn at that level
+  void copyCoarseFrom(const ChunkData &chunk, int lodLevel, int srcX0, int srcZ0, int dstX0, int dstZ0, int width, int depth);
+  // most common block of a coarse cell, ties go to occluding blocks so thin surfaces survive the vote
+  static BlockType majorityBlock(const int (&counts)[blockTypeCount]);
+  void clear(glm::ivec3 worldPosition);
+};
+
+#endif
\ No newline at end of file
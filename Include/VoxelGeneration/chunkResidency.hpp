@@ -0,0 +1,74 @@
+#pragma once
+#include "chunkData.hpp"
+#include "MutlithreadingQueue.hpp"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct ResidencyStats
+{
+  // requests for the blocks of a chunk, answered by the tier or passed on to the next one
+  uint64_t hotHits;
+  uint64_t hotMisses;
+  uint64_t warmHits;
+  uint64_t warmMisses;
+  // disk hits had saved edits, misses were plain generated terrain
+  uint64_t diskHits;
+  uint64_t diskMisses;
+  uint64_t demotions;
+  uint64_t evictions;
+  size_t hotBytes;
+  size_t warmBytes;
+  size_t warmChunks;
+};
+
+// Chunks in three tiers. Hot chunks are the uncompressed ones in World::chunks, kept by distance
+// to the player. Unloaded chunks are demoted to the warm tier here, compressed with encodeChunk on a
+// worker and promoted back for a fraction of the cost of rebuilding them. Warm chunks get what the
+// hot ones leave of memoryBudget and the least recently unloaded are evicted to the disk tier, which
+// regenerates the terrain and applies the saved edits. Thread safe.
+class ChunkResidency
+{
+public:
+  // hot and warm chunks together, hot chunks are never evicted
+  size_t memoryBudget = size_t(64) << 20;
+
+  // the chunk was unloaded and must not change anymore, compress it on a worker next
+  void demote(const glm::ivec3 &chunkPos, std::shared_ptr<ChunkData> chunk);
+  // does nothing if the chunk was promoted or evicted meanwhile
+  void compress(const glm::ivec3 &chunkPos, const std::shared_ptr<ChunkData> &chunk);
+  // the demoted chunk, or nullptr if it is not in the warm tier
+  std::shared_ptr<ChunkData> promote(const glm::ivec3 &chunkPos);
+
+  // memory of the hot chunks, measured by the caller
+  void setHotBytes(size_t bytes);
+  void countHot(bool hit);
+  void countDisk(bool hit);
+  ResidencyStats stats() const;
+
+private:
+  struct Entry
+  {
+    // the uncompressed chunk until compress ran
+    std::shared_ptr<ChunkData> chunk;
+    std::vector<uint8_t> bytes;
+    size_t size;
+    std::list<glm::ivec3>::iterator recent;
+  };
+
+  mutable std::mutex mtx;
+  std::unordered_map<glm::ivec3, Entry, ChunkHasher> entries;
+  // most recently unloaded first
+  std::list<glm::ivec3> recentlyUnloaded;
+  size_t warmBytes = 0;
+  size_t hotBytes = 0;
+  ResidencyStats counters = {};
+
+  // expects mtx to be held
+  void remove(std::unordered_map<glm::ivec3, Entry, ChunkHasher>::iterator entry);
+  void evict();
+};
@@ -0,0 +1,221 @@
+#pragma once
+#include "chunkData.hpp"
+#include "chunkIO.hpp"
+#include "editJournal.hpp"
+#include "MutlithreadingQueue.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// Holds the chunks of regionSize x regionSize chunk columns in one file. The first sector is a table
+// with the location of every chunk, (first sector << 8) | sector count, or 0 if it is not stored.
+// A stored chunk is its byte length followed by the bytes, padded to whole sectors. Only the table is
+// kept here, the chunk bytes are read and written by ChunkStorage through the backend. Not thread safe.
+class RegionFile
+{
+public:
+  static const int regionSize = 32;
+  static const int sectorSize = 4096;
+  static const int maxSectorsPerChunk = 255;
+
+  RegionFile(IOBackend &backend, const std::string &path);
+  ~RegionFile();
+
+  RegionFile(const RegionFile &) = delete;
+  RegionFile &operator=(const RegionFile &) = delete;
+
+  bool isOpen() const
+  {
+    return file >= 0;
+  }
+
+  int handle() const
+  {
+    return file;
+  }
+
+  uint32_t location(int index) const
+  {
+    return locations[index];
+  }
+
+  // first sector of a free run of sectorCount sectors, marked as used
+  int allocate(int sectorCount);
+  void release(uint32_t location);
+  // call once the chunk bytes and its table entry are written. The sectors of the old copy are freed
+  // once no read of the file is in flight, as one may still be reading them
+  void setLocation(int index, uint32_t location);
+  void beginRead();
+  void endRead();
+
+  // requests on the file in flight, it is only closed without any
+  int operations = 0;
+
+  // region of a chunk, in regions
+  static glm::ivec3 regionOf(const glm::ivec3 &chunkPos);
+  // index of a chunk in the location table of its region
+  static int chunkIndex(const glm::ivec3 &chunkPos);
+
+private:
+  IOBackend &backend;
+  int file = -1;
+  uint32_t locations[regionSize * regionSize];
+  // sector 0 holds the location table
+  std::vector<bool> usedSectors;
+  int reads = 0;
+  std::vector<uint32_t> replacedLocations;
+};
+
+// what a chunk is rebuilt from: the copy in its region file, used in place, and the edits made since
+struct ChunkPayload
+{
+  std::vector<uint8_t> bytes;
+  size_t offset = 0;
+  size_t size = 0;
+  std::vector<BlockEdit> journalEdits;
+};
+
+struct ChunkIOStats
+{
+  const char *backend;
+  // chunk reads and writes waiting for the I/O thread, and taken by it but not finished
+  int queued;
+  int inFlight;
+  int peakDepth;
+  uint64_t reads;
+  uint64_t writes;
+  // milliseconds from request to completion over the latest requests
+  float latencyP50Ms;
+  float latencyP90Ms;
+  float latencyP99Ms;
+  float latencyMaxMs;
+};
+
+// Saved worlds under a directory. Chunks are never saved whole: gameplay edits go to an append only
+// journal, and compaction moves them into per chunk edit snapshots in region files of 32x32 chunk
+// columns. Loading regenerates the terrain and applies the snapshot and the newer journal edits, so
+// the disk cost follows the edits instead of the explored area. Every disk access runs on one I/O
+// thread, which batches the requests through io_uring where the kernel offers it and through a few
+// blocking I/O threads elsewhere, so neither the renderer nor the workers wait on the disk.
+class ChunkStorage
+{
+public:
+  using ReadCallback = std::function<void(ChunkPayload &&payload)>;
+  using Generator = std::function<std::shared_ptr<ChunkData>()>;
+
+  // replays the journals a crashed session left behind
+  explicit ChunkStorage(std::string directory);
+  // appends the remaining edits to the journal
+  ~ChunkStorage();
+
+  ChunkStorage(const ChunkStorage &) = delete;
+  ChunkStorage &operator=(const ChunkStorage &) = delete;
+
+  // done runs on the I/O thread with the region copy and the journal edits of the chunk. Keep it
+  // short and rebuild the chunk on a worker
+  void read(const glm::ivec3 &chunkPos, ReadCallback done);
+  // read, waiting for the disk; never call it from a read callback
+  ChunkPayload readAndWait(const glm::ivec3 &chunkPos);
+  // the generated chunk with every edit of the payload applied
+  static std::shared_ptr<ChunkData> rebuild(const glm::ivec3 &chunkPos, const ChunkPayload &payload, const Generator &generate);
+
+  // records a gameplay change of a loaded chunk, the I/O thread appends it to the journal
+  void recordEdit(const glm::ivec3 &chunkPos, const BlockEdit &edit);
+  // moves every recorded edit into the region files and waits until the I/O thread is idle
+  void compactJournal();
+
+  ChunkIOStats stats() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  // a region file copy is [version][edit snapshot], copies of other versions are regenerated
+  static const uint8_t formatVersion = 2;
+  static const size_t maxOpenRegions = 16;
+  // journal bytes that start a compaction, about 5000 edits
+  static const size_t compactionBytes = 64 * 1024;
+  // requests in the ring at once, and threads of the fallback backend
+  static const unsigned ringDepth = 64;
+  static const unsigned fallbackThreads = 2;
+  static const size_t latencySamples = 1024;
+
+  enum class OperationKind
+  {
+    Read,
+    // reads the region copy of a chunk and writes it back with the compacted edits merged in
+    Compact,
+    Append
+  };
+
+  // one read, compaction or journal append from the request to its completion, owned by the I/O thread once taken
+  struct Operation
+  {
+    OperationKind kind;
+    glm::ivec3 chunkPos;
+    Clock::time_point requested;
+    // the sectors read or written, or the journal records
+    std::vector<uint8_t> buffer;
+    ReadCallback done;
+    // the journal edits of a read, taken when it starts so a compaction finishing meanwhile can't drop them
+    std::vector<BlockEdit> journalEdits;
+
+    RegionFile *region = nullptr;
+    uint32_t location = 0;
+    uint8_t tableEntry[4];
+  };
+
+  std::string directory;
+  std::unique_ptr<IOBackend> backend;
+
+  // guards everything up to ioThread
+  mutable std::mutex mtx;
+  std::condition_variable idle;
+  EditJournal journal;
+  std::vector<std::unique_ptr<Operation>> requests;
+  bool compactionRequested = false;
+  int operationsInFlight = 0;
+  int peakDepth = 0;
+  uint64_t reads = 0;
+  uint64_t writes = 0;
+  std::vector<float> latencies;
+  size_t nextLatency = 0;
+  bool stopping = false;
+
+  // only used on the I/O thread
+  std::unordered_map<glm::ivec3, std::unique_ptr<RegionFile>, ChunkHasher> regions;
+  // edits are appended to the newest journal; older ones are deleted once their edits are compacted
+  int journalGeneration = 0;
+  int journalFile = -1;
+  uint64_t journalEnd = 0;
+  int retiredJournalFile = -1;
+  std::vector<std::string> retiredJournals;
+  int appendsInFlight = 0;
+  bool compactionRunning = false;
+  // chunks of the running compaction not written yet
+  int compactionsLeft = 0;
+  bool compactionFailed = false;
+  std::thread ioThread;
+
+  std::string journalPath(int generation) const;
+  void openJournal();
+  void ioLoop();
+  void startCompaction(const std::vector<glm::ivec3> &chunks, std::vector<IORequest> &batch);
+  void append(std::vector<uint8_t> &&records, std::vector<IORequest> &batch);
+  void startRead(Operation *operation, std::vector<IORequest> &batch);
+  void readFinished(Operation *operation, int64_t result);
+  void writeSnapshot(Operation *operation, const ChunkPayload &stored);
+  void writeTableEntry(Operation *operation);
+  void snapshotWritten(Operation *operation, bool written);
+  void finishCompaction();
+  void finish(Operation *operation);
+  RegionFile *openRegion(const glm::ivec3 &chunkPos);
+
+  static bool parseStored(const uint8_t *data, size_t size, std::vector<BlockEdit> &edits);
+};
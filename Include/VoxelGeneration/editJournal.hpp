@@ -0,0 +1,67 @@
+#pragma once
+#include "chunkData.hpp"
+#include "MutlithreadingQueue.hpp"
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// a block changed by gameplay, index (y << 8) | (z << 4) | x inside its chunk
+struct BlockEdit
+{
+  uint16_t index;
+  BlockType before;
+  BlockType after;
+};
+
+// Edits made to chunks since they were last compacted into their region files. Every edit is also
+// appended to the journal file as a record of chunk x, chunk z (in chunks), index, before and after,
+// so the player's changes survive a crash while untouched chunks are never written. Not thread safe.
+class EditJournal
+{
+public:
+  static const int recordSize = 12;
+
+  static uint16_t blockIndex(int x, int y, int z)
+  {
+    return static_cast<uint16_t>(y << 8 | z << 4 | x);
+  }
+
+  // applied in order, so replaying edits a snapshot already holds changes nothing
+  static void apply(const std::vector<BlockEdit> &edits, ChunkData &chunk);
+  // one edit per block, with the first before and the last after; blocks changed back are dropped
+  static std::vector<BlockEdit> merge(const std::vector<BlockEdit> &older, const std::vector<BlockEdit> &newer);
+  // edit count, then index, before and after of every edit
+  static void encodeSnapshot(const std::vector<BlockEdit> &edits, std::vector<uint8_t> &out);
+  // false if the bytes are malformed or hold a type other than Air to Tree_Leafes_Solid
+  static bool decodeSnapshot(const uint8_t *data, size_t size, std::vector<BlockEdit> &edits);
+
+  void record(const glm::ivec3 &chunkPos, const BlockEdit &edit);
+  // adds the records of a journal file, a record cut off at the end or with an unknown type is ignored
+  void replay(const uint8_t *data, size_t size);
+
+  // edits of the chunk not compacted yet, oldest first
+  std::vector<BlockEdit> editsOf(const glm::ivec3 &chunkPos) const;
+  // journal bytes recorded or replayed since the last compaction started
+  size_t bytesSinceCompaction() const
+  {
+    return journalBytes;
+  }
+
+  // moves the recorded edits to compacting, false if there are none
+  bool beginCompaction();
+  // drops the compacted edits, or puts them back in front of newer ones if they were not written
+  void endCompaction(bool written);
+  const std::unordered_map<glm::ivec3, std::vector<BlockEdit>, ChunkHasher> &compactingEdits() const
+  {
+    return compacting;
+  }
+
+  // records not yet appended to the journal file
+  std::vector<uint8_t> unwritten;
+
+private:
+  std::unordered_map<glm::ivec3, std::vector<BlockEdit>, ChunkHasher> edits;
+  std::unordered_map<glm::ivec3, std::vector<BlockEdit>, ChunkHasher> compacting;
+  size_t journalBytes = 0;
+};
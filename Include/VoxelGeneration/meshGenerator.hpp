@@ -1,8 +1,10 @@
 #pragma once
 #include "chunkData.hpp"
-#include <vertex.h>
+#include "chunkNeighborhood.hpp"
+#include <voxelVertex.h>
 #include <memory>
 #include "blockDataSO.hpp"
+#include "MutlithreadingQueue.hpp"
 
 const glm::ivec3 directions[6] = {
     {1, 0, 0},
@@ -26,13 +28,84 @@ const glm::vec3 faceVertices[6][4] = {
     // -Z
     {{0.5, -0.5, -0.5}, {-0.5, -0.5, -0.5}, {-0.5, 0.5, -0.5}, {0.5, 0.5, -0.5}}};
 
+// plane axes of each face axis, u and v follow the texture coordinates of faceVertices
+const int faceUAxis[3] = {2, 2, 0};
+const int faceVAxis[3] = {1, 0, 1};
+
+enum class MeshingMode
+{
+  Naive,
+  Greedy,
+  Binary
+};
+
+// translucent blocks go into their own mesh so they can be blended after all opaque chunks
+inline bool isTranslucent(BlockType block)
+{
+  return block == BlockType::Water;
+}
+
+// blocks that darken the corners of faces next to them
+inline bool isOccluder(BlockType block)
+{
+  return block != BlockType::Nothing && block != BlockType::Air && block != BlockType::Water;
+}
+
+inline bool isFaceVisible(BlockType block, BlockType neighborBlock)
+{
+  if (block == BlockType::Nothing || block == BlockType::Air)
+    return false;
+  return neighborBlock == BlockType::Nothing || neighborBlock == BlockType::Air || (block != BlockType::Water && neighborBlock == BlockType::Water);
+}
+
 class World;
 class MeshGenerator
 {
 public:
-  std::vector<Vertex> vertices;
-  std::vector<uint32_t> indices;
+  // one entry per meshed section, four vertices per quad, drawn with the renderer's shared quad index buffer
+  std::vector<SectionMeshData> sectionMeshes;
+  // when set, section buffers are taken from this pool instead of allocated
+  MeshBufferPool *bufferPool = nullptr;
+
+  MeshingMode meshingMode = MeshingMode::Binary;
+  // off leaves every corner open, reduced resolution chunks are always meshed that way
+  bool ambientOcclusion = true;
+  ChunkNeighborhood neighborhood;
+  ChunkNeighborhood lodNeighborhood;
+
+  // snapshots the chunk and its border under a single World lock, then meshes the snapshot
+  // only the sections set in sectionMask are meshed
+  bool generateMesh(World *world, BlockDataSO &textureData, const std::shared_ptr<ChunkData> &chunk, uint16_t sectionMask = ChunkData::allSections);
+  bool generateMesh(const ChunkNeighborhood &blocks, BlockDataSO &textureData, uint16_t sectionMask = ChunkData::allSections);
+  void naiveMesh(const ChunkNeighborhood &blocks, BlockDataSO &textureData, int section);
+  void greedyMeshDirection(const ChunkNeighborhood &blocks, BlockDataSO &textureData, int face, int section);
+  // same quads as the greedy mesher, but face culling runs on 64 block tall occupancy columns
+  void buildFaceColumns(const ChunkNeighborhood &blocks, uint16_t sectionMask);
+  void binaryMeshDirection(const ChunkNeighborhood &blocks, BlockDataSO &textureData, int face, int section);
+  // replaces every 2^lodLevel cube of the chunk with its most common block so the mesher merges the
+  // coarse cells, the border already holds the neighbors as they are drawn (see World::buildNeighborhood)
+  void prepareLodNeighborhood(const ChunkNeighborhood &blocks, ChunkNeighborhood &target);
+
+private:
+  static const int columnBands = ChunkData::chunkHeight / 64;
+
+  // block type in the low byte and the packed corner occlusion in the high byte, 0 where no face is visible
+  std::vector<uint16_t> faceMask;
+
+  // bit y of band b is block y + 64 * b of a column, one column per (x, z) of the neighborhood
+  std::vector<uint64_t> opaqueColumns;
+  std::vector<uint64_t> waterColumns;
+  // visible faces per face direction, one column per (x, z) inside the chunk
+  std::vector<uint64_t> faceColumns;
+  // visible faces of one direction in one section as 16 bit rows along u, indexed by slice * 16 + v
+  uint16_t facePlane[16 * 16];
+  // corner occlusion of every visible face in facePlane, 16 entries per row
+  uint8_t faceOcclusion[16 * 16 * 16];
 
-  bool generateMesh(World *world, BlockDataSO &textureData, const std::shared_ptr<ChunkData> &chunk);
-  void greedyMeshDirection(World *world, BlockDataSO &textureData, const std::shared_ptr<ChunkData> &chunk, int face, uint32_t &indexCount);
+  // adds one face of the box at origin with the given size, the texture repeats once per block
+  void addQuad(BlockDataSO &textureData, BlockType block, int face, glm::ivec3 origin, glm::ivec3 size, int ambientOcclusion);
+  // occlusion of the four corners of one block face (2 bits per corner, in faceVertices order), 3 is open
+  int faceAmbientOcclusion(const ChunkNeighborhood &blocks, glm::ivec3 pos, int face) const;
+  // off for reduced resolution chunks, where it only splits quads that are too far away to show it
+  bool bakeAmbientOcclusion = true;
 };
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+// classic 2D Perlin noise, the same float operations in the same order as glm::perlin(vec2)
+float perlinNoise(float x, float y);
+
+// perlinNoise for count points, 8 (AVX2) or 4 (SSE2) points per step with a scalar tail
+void perlinNoiseBatch(const float *x, const float *y, float *result, int count);
+
+// octaves of perlin noise, each rotated 0.5 rad further, frequency multiplied by lacunarity and
+// amplitude by persistence per octave. scale is per point, persistence and amplitude are per point
+// or nullptr for 1. offsetX and offsetY are added to the sample coordinates of every octave after scaling,
+// they move the field in noise space where a varying scale cannot stretch the shift
+void fractalNoiseBatch(const float *x, const float *y, int count, int octaves, float lacunarity, const float *scale, const float *persistence, const float *amplitude, float *result,
+                       float offsetX = 0.0f, float offsetY = 0.0f);
+
+// Slowly varying fields are sampled every spacing blocks and interpolated. A lattice covers size
+// blocks per axis with size / spacing + 1 samples, so neighboring areas share their border samples.
+// Lattice and result are indexed x major, like the chunk columns: (x * samplesZ + z)
+int latticeSamples(int size, int spacing);
+void bilinearUpsample(const float *lattice, int spacing, int size, float *result);
@@ -0,0 +1,76 @@
+#ifndef PALETTE_STORAGE_H
+#define PALETTE_STORAGE_H
+#include "blockType.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Stores a fixed number of blocks as indices into a small palette of block types.
+// Indices are packed into 64 bit words at 1, 2, 4 or 8 bits per entry, so no entry
+// ever straddles two words. The index width doubles whenever the palette outgrows it.
+// While only one block type is present nothing is allocated besides the palette.
+class PaletteStorage
+{
+public:
+  PaletteStorage(int size, BlockType initial);
+
+  BlockType get(int index) const
+  {
+    if (data.empty())
+      return palette[0];
+
+    uint64_t word = data[index >> entriesShift];
+    int shift = (index & entriesMask) << bitsShift;
+    return palette[(word >> shift) & valueMask];
+  }
+
+  void set(int index, BlockType type);
+
+  void fill(BlockType type);
+
+  // replaces every entry at once, packed at the smallest width like after compact
+  void assign(const BlockType *blocks);
+
+  // drops unused palette entries and repacks at the smallest width, collapsing to a single value if possible
+  void compact();
+
+  bool isUniform() const
+  {
+    return data.empty();
+  }
+
+  BlockType getUniformBlock() const
+  {
+    return palette[0];
+  }
+
+  const std::vector<BlockType> &getPalette() const
+  {
+    return palette;
+  }
+
+  int getBitsPerEntry() const
+  {
+    return data.empty() ? 0 : 1 << bitsShift;
+  }
+
+  size_t memoryUsage() const
+  {
+    return data.capacity() * sizeof(uint64_t) + palette.capacity() * sizeof(BlockType);
+  }
+
+private:
+  int size;
+  int bitsShift;    // log2 of bits per entry
+  int entriesShift; // log2 of entries per 64 bit word
+  int entriesMask;
+  uint64_t valueMask;
+  std::vector<BlockType> palette;
+  std::vector<uint64_t> data;
+
+  void setBitsShift(int newBitsShift);
+  void repack(int newBitsShift, const std::vector<int> &remap);
+  int findOrAddPaletteEntry(BlockType type);
+};
+
+#endif
\ No newline at end of file
@@ -1,18 +1,33 @@
 #include <unordered_map>
+#include <unordered_set>
 #include "chunkData.hpp"
 #include <glm/glm.hpp>
 #include <memory>
+#include <optional>
 #include "meshGenerator.hpp"
 #include "blockDataSO.hpp"
 #include "MutlithreadingQueue.hpp"
+#include "jobSystem.hpp"
+#include "chunkStorage.hpp"
+#include "chunkResidency.hpp"
 #include <thread>
 #include <random>
 
-struct BlockQueueData
+// every noise offset and random choice of world generation derives from the seed, the same seed
+// always generates the same world
+using WorldSeed = uint64_t;
+
+// splitmix64 of seed and salt, independent well mixed bits for every salt
+inline uint64_t mixSeed(uint64_t seed, uint64_t salt)
 {
-  glm::ivec3 blockPos;
-  BlockType blockType;
-};
+  uint64_t z = seed + 0x9E3779B97F4A7C15ull * (salt + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// index into World::biomes
+using BiomeId = uint8_t;
 
 struct Biome
 {
@@ -27,6 +42,7 @@ struct Biome
   int heightDiff;
   float persistance;
   float lacunarity;
+  bool hasTrees;
 
   Biome(const char *name,
         BlockType surfaceBlock,
@@ -38,7 +54,8 @@ struct Biome
         int elevation,
         int heightDiff,
         float persistance,
-        float lacunarity)
+        float lacunarity,
+        bool hasTrees = false)
       : name(name),
         surfaceBlock(surfaceBlock),
         underwaterSurfaceBlock(underwaterSurfaceBlock),
@@ -49,17 +66,28 @@ struct Biome
         elevation(elevation),
         heightDiff(heightDiff),
         persistance(persistance),
-        lacunarity(lacunarity)
+        lacunarity(lacunarity),
+        hasTrees(hasTrees)
   {
   }
 };
 
-struct ChunkHasher
+// generated terrain of the 16x16 columns of a chunk, index x * chunkSize + z
+struct ChunkColumns
 {
-  size_t operator()(const glm::ivec3 &v) const
-  {
-    return std::hash<int>()(v.x) ^ (std::hash<int>()(v.y) << 1) ^ (std::hash<int>()(v.z) << 2);
-  }
+  BiomeId biome[ChunkData::chunkSize * ChunkData::chunkSize];
+  int terrainHeight[ChunkData::chunkSize * ChunkData::chunkSize];
+  // one of the columns is in a biome with trees, trees then grow anywhere in the chunk
+  bool hasTrees = false;
+};
+
+struct TreePlacement
+{
+  // lowest trunk block, relative to the chunk the tree grows from
+  glm::ivec3 position;
+  int trunkHeight;
+  int trunkWidth;
+  int leafRadius;
 };
 
 class Engine;
@@ -69,19 +97,49 @@ public:
   MeshGenerator meshGenerator;
   BlockDataSO textureDataSource;
   std::vector<Biome> biomes;
+  const WorldSeed seed;
   std::unordered_map<glm::ivec3, std::shared_ptr<ChunkData>, ChunkHasher> chunks;
-  std::unordered_map<glm::ivec3, std::vector<BlockQueueData>, ChunkHasher> blocksQueue;
 
-  World();
+  // chunk edits are saved under saveDirectory and survive a restart; without one the world lives in memory only.
+  // parameterLatticeSpacing must divide ChunkData::chunkSize, std::invalid_argument is thrown otherwise
+  explicit World(WorldSeed seed = 0, const std::string &saveDirectory = "", int parameterLatticeSpacing = 4);
+  ~World();
+
+  // hits and misses of the hot, warm and disk tiers, and the memory of the hot and warm tiers
+  ResidencyStats residencyStats() const;
+  // chunk I/O of the save directory, nothing for a world kept in memory
+  std::optional<ChunkIOStats> storageStats() const;
 
   BlockType getBlock(int x, int y, int z) const;
 
   int setBlock(int x, int y, int z, BlockType type);
 
+  bool isSectionEmpty(int x, int y, int z) const;
+
+  void buildNeighborhood(const glm::ivec3 &chunkPos, ChunkNeighborhood &neighborhood) const;
+
+  // chunks closer than lodDistance chunks are meshed at full resolution, every doubling of the
+  // distance after that halves the resolution, up to maxLodLevel
+  static const int maxLodLevel = 3;
+  int lodDistance = 6;
+  float lodHysteresis = 0.5f;
+
+  int selectLodLevel(int currentLevel, float chunkDistance) const;
+  // sets the level and queues the chunk and its side neighbors for remeshing
+  void setLodLevel(const glm::ivec3 &chunkPos, int lodLevel);
+  // true if the chunk is not loaded yet, or has to be remeshed and can be because its neighbors are loaded
+  bool chunkNeedsUpdate(const glm::ivec3 &chunkPos) const;
+  // bumped whenever chunkNeedsUpdate may have turned true for some chunk: a load finished or was
+  // abandoned, a block was set or a level changed
+  std::atomic<uint64_t> chunkChanges = 0;
+
   void loadChunk(const glm::ivec3 &chunkPos);
 
+  // takes chunkMutex
   bool hasChunk(const glm::ivec3 &chunkPos) const;
 
+  // demotes the chunk to the warm tier of residency and drops the tree plans no loaded chunk needs,
+  // the chunk's edits are already journaled; expects chunkMutex to be held
   void unloadChunk(const glm::ivec3 &chunkPos);
 
   glm::ivec3 worldToChunkCoords(int x, int y, int z) const;
@@ -90,74 +148,80 @@ public:
 
   void renderChunk(Engine *engine, std::string identifier, const glm::ivec3 &chunkPos);
 
+  // depends only on the seed and the chunk position, never on which chunks are loaded or on which
+  // thread it runs
   void generateChunk(const glm::ivec3 &chunkPos);
-
-  std::pair<int, BlockType> getSurfaceBlock(std::shared_ptr<ChunkData> chunk, int x, int z)
-  {
-    for (int y = ChunkData::chunkHeight - 1; y >= 0; --y)
-    {
-      BlockType type = chunk->getBlock(x, y, z);
-      if (type != BlockType::Air && type != BlockType::Nothing)
-        return {y, type};
-    }
-    return {-1, BlockType::Nothing};
-  }
-
-  void generateTreeAt(std::shared_ptr<ChunkData> chunk, const glm::ivec3 &position, std::mt19937 &rng);
-
-  std::pair<float, Biome> getBiome(float temperature, float humidity, float elevation);
-  std::pair<float, Biome> getBiomeSecondary(float temperature, float humidity, float elevation);
+  // the generated chunk without adding it to chunks, saved chunks are rebuilt from it
+  std::shared_ptr<ChunkData> generateChunkData(const glm::ivec3 &chunkPos);
+  // spacing in blocks of the lattice the terrain parameters are sampled on, 1 samples every column;
+  // divides ChunkData::chunkSize so neighboring chunks share their border samples
+  const int parameterLatticeSpacing;
+  static constexpr int waterLevel = 60;
+
+  void sampleClimate(const glm::ivec3 &chunkPos, ChunkColumns &columns) const;
+  void sampleHeights(const glm::ivec3 &chunkPos, ChunkColumns &columns) const;
+  // trees growing from the chunk, in the order they are stamped
+  std::vector<TreePlacement> planTrees(const glm::ivec3 &chunkPos, const ChunkColumns &columns) const;
+  // planTrees of any chunk, cached in treePlans
+  std::vector<TreePlacement> plannedTrees(const glm::ivec3 &chunkPos);
+  // writes the blocks of a tree growing from the chunk sourceOffset blocks away that fall inside this chunk
+  void stampTree(ChunkData &chunk, const glm::ivec3 &sourceOffset, const TreePlacement &tree) const;
+
+  // squared climate distance and id of the nearest and second nearest biome, scans every biome
+  std::pair<float, BiomeId> getBiome(float temperature, float humidity, float elevation) const;
+  std::pair<float, BiomeId> getBiomeSecondary(float temperature, float humidity, float elevation) const;
+  // same biome as getBiome, read from biomeLookup where possible
+  BiomeId lookupBiome(float temperature, float humidity, float elevation) const;
+  // call after changing biomes
+  void buildBiomeLookup();
 
   ChunkQueue chunkLoadQueue;
   CompletedQueue completedMeshes;
-  std::atomic<bool> running = true;
+  // buffers of uploaded meshes go back here for the workers to reuse
+  MeshBufferPool meshBufferPool;
+  std::atomic<MeshingMode> meshingMode = MeshingMode::Binary;
   mutable std::mutex chunkMutex;
   mutable std::mutex chunkDeletionMutex;
 
-  void chunkWorker()
-  {
-
-    MeshGenerator threadMeshGenerator;
-    while (running)
-    {
-      glm::ivec3 pos;
-      if (chunkLoadQueue.pop(pos))
-      {
-        loadChunk(pos);
-
-        bool needsMeshing = false;
-        std::shared_ptr<ChunkData> chunk;
-        {
-          std::lock_guard<std::mutex> lock(chunkMutex);
-          needsMeshing = chunks.find(pos) != chunks.end() && chunks.at(pos)->modifiedChunk;
-
-          if (needsMeshing)
-          {
-            chunk = chunks.at(pos);
-            chunk->modifiedChunk = false;
-          }
-        }
-
-        if (needsMeshing)
-        {
-          std::vector<Vertex> vertices;
-          std::vector<uint32_t> indices;
-          std::lock_guard<std::mutex> lock(chunkDeletionMutex);
-          threadMeshGenerator.generateMesh(this, textureDataSource, chunk);
-
-          completedMeshes.push({pos, std::move(threadMeshGenerator.vertices), std::move(threadMeshGenerator.indices)});
-        }
-      }
-      else
-      {
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-      }
-    }
-  }
-  void startWorker()
-  {
-    std::thread([this]()
-                { this->chunkWorker(); })
-        .detach();
-  }
+  // unloaded chunks are saved here and loaded again instead of being regenerated, null without a save directory
+  std::unique_ptr<ChunkStorage> chunkStorage;
+  // unloaded chunks stay compressed in memory while the budget allows, before they are rebuilt from chunkStorage or generated again
+  ChunkResidency residency;
+
+  // generation, meshing and later chunk work runs as jobs on these workers
+  JobSystem jobSystem;
+
+  void startWorkers();
+  void stopWorkers();
+  // queues the chunk and submits a job for the nearest queued chunk: missing chunks are generated,
+  // loaded ones are meshed
+  void queueChunk(const glm::ivec3 &chunkPos);
+  void processQueuedChunk();
+  // rebuilds the chunk read for a queued request from the saved edits and generated terrain
+  void finishLoading(const glm::ivec3 &pos, const ChunkPayload &payload);
+  // forgets a load whose finished read was rejected by the stopped workers
+  void abandonLoading(const glm::ivec3 &pos);
+  // inserts a chunk that was being loaded and queues meshing
+  void chunkLoaded(const glm::ivec3 &pos, std::shared_ptr<ChunkData> chunk);
+  // meshing stage, runs once the chunk and its eight horizontal neighbors are generated
+  void queueMeshing(const glm::ivec3 &chunkPos);
+  void meshChunk(const glm::ivec3 &chunkPos);
+
+private:
+  // nearest biome for every climate cell over [0, 1) per axis, indexed
+  // (temperature * size + humidity) * size + elevation. Cells a biome border passes through hold
+  // mixedBiomeCell and are resolved by getBiome
+  static constexpr int biomeLookupSize = 64;
+  static constexpr BiomeId mixedBiomeCell = 0xFF;
+  std::vector<BiomeId> biomeLookup;
+
+  // trees of recently generated chunks and their neighbors, so neighbors do not plan them again
+  std::unordered_map<glm::ivec3, std::vector<TreePlacement>, ChunkHasher> treePlans;
+  std::mutex treePlanMutex;
+
+  // chunks being generated right now, guarded by chunkMutex
+  std::unordered_set<glm::ivec3, ChunkHasher> chunksLoading;
+
+  // expects chunkMutex to be held
+  bool neighborsLoaded(const glm::ivec3 &chunkPos) const;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include "vertex.h"
+#include "voxelVertex.h"
 class BufferManager
 {
 public:
@@ -18,6 +19,11 @@ public:
   std::vector<VkBuffer> indexBuffers;
   std::vector<VkDeviceMemory> indexBufferMemory;
 
+  // shared 0,1,2,2,3,0 + 4k index buffer for meshes made of quads
+  VkBuffer quadIndexBuffer = VK_NULL_HANDLE;
+  VkDeviceMemory quadIndexBufferMemory = VK_NULL_HANDLE;
+  uint32_t quadIndexCapacity = 0;
+
   std::vector<VkBuffer> shaderStorageBuffers;
   std::vector<VkDeviceMemory> shaderStorageBuffersMemory;
 
@@ -25,16 +31,26 @@ public:
   std::vector<VkDeviceMemory> uniformBuffersMemory;
   std::vector<void *> uniformBuffersMapped;
 
+  // one VoxelFrameUniforms per frame in flight
+  std::vector<VkBuffer> voxelFrameBuffers;
+  std::vector<VkDeviceMemory> voxelFrameBuffersMemory;
+  std::vector<void *> voxelFrameBuffersMapped;
+
   void createUniformBuffers(int MAX_FRAMES_IN_FLIGHT, VkDevice device, VkPhysicalDevice physicalDevice, int count);
+  void createVoxelFrameBuffers(int MAX_FRAMES_IN_FLIGHT, VkDevice device, VkPhysicalDevice physicalDevice);
   void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory, VkDevice device, VkPhysicalDevice physicalDevice);
 
   void freeVertexBuffer(int index, VkDevice device, VkQueue graphicsQueue);
   void freeIndexBuffer(int index, VkDevice device, VkQueue graphicsQueue);
 
   void createVertexBuffer(const std::vector<Vertex> &verts, int targetBuffer, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+  void createVertexBuffer(const std::vector<VoxelVertex> &verts, int targetBuffer, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+  void createVertexBuffer(const void *verts, VkDeviceSize bufferSize, int targetBuffer, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
   void createIndexBuffer(const std::vector<uint32_t> &inputIndices, int targetBuffer, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+  void createQuadIndexBuffer(uint32_t quadCount, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
 
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue);
   void cleanup(VkDevice device);
   void updateUniformBuffer(uint32_t currentImage, glm::mat4 transformation, glm::mat4 view, glm::mat4 proj);
+  void updateVoxelFrameBuffer(uint32_t currentImage, glm::mat4 view, glm::mat4 proj, glm::vec3 viewPos);
 };
\ No newline at end of file
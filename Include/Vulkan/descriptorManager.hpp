@@ -10,6 +10,8 @@ public:
   VkDescriptorSetLayout descriptorSetLayout;
   VkDescriptorPool descriptorPool;
   std::vector<VkDescriptorSet> descriptorSets;
+  // one set per frame in flight, shared by every voxel mesh
+  std::vector<VkDescriptorSet> voxelDescriptorSets;
   BufferManager &bufferManager;
   DescriptorManager(BufferManager &bufferManager) : bufferManager(bufferManager)
   {
@@ -21,6 +23,7 @@ public:
   void createDescriptorPool(VkDevice device, int MAX_FRAMES_IN_FLIGHT, int count);
   void createDescriptorSets(VkDevice device, int MAX_FRAMES_IN_FLIGHT, int count, VkImageView textureImageView, VkSampler textureSampler);
   void addDescriptorSets(VkDevice device, int MAX_FRAMES_IN_FLIGHT, int count, VkImageView textureImageView, VkSampler textureSampler);
+  void createVoxelDescriptorSets(VkDevice device, int MAX_FRAMES_IN_FLIGHT, VkImageView textureImageView, VkSampler textureSampler);
 
   void cleanup(VkDevice device);
 };
\ No newline at end of file
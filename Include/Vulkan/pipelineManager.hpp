@@ -15,6 +15,9 @@ public:
   VkPipelineLayout pipelineLayout;
   VkPipeline graphicsPipeline;
 
+  VkPipelineLayout voxelPipelineLayout;
+  VkPipeline voxelPipeline;
+
   SwapchainManager &swapchainManager;
   DescriptorManager &descriptorManager;
   std::vector<VkDynamicState> dynamicStates = {
@@ -28,9 +31,11 @@ public:
   }
   void createRenderPass(VkDevice device, VkPhysicalDevice physicalDevice);
   void createGraphicsPipeline(VkDevice device);
+  void createVoxelPipeline(VkDevice device);
   void cleanup(VkDevice device);
 
 private:
   static std::vector<char> readFile(const std::string &filename);
   static VkShaderModule createShaderModule(const std::vector<char> &code, VkDevice device);
+  void createPipeline(VkDevice device, const std::string &vertShaderPath, const std::string &fragShaderPath, const VkPipelineVertexInputStateCreateInfo &vertexInputInfo, uint32_t pushConstantSize, VkPipelineLayout &layout, VkPipeline &pipeline);
 };
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// range of one voxel mesh inside an arena page
+struct VoxelAllocation
+{
+  int page = -1;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+};
+
+// suballocates chunk section vertices from a few large device local buffers,
+// so loaded sections cost no device allocation of their own. Pages are mapped and written
+// directly where the device exposes host visible device local memory (resizable BAR, or any
+// integrated GPU); otherwise vertices go through staging buffers and are copied in by flushUploads
+class VoxelArena
+{
+public:
+  static constexpr VkDeviceSize pageSize = 32ull << 20;
+  static constexpr VkDeviceSize stagingSize = 4ull << 20;
+  // one quad of VoxelVertex, keeps every range quad aligned
+  static constexpr VkDeviceSize granularity = 32;
+
+  void init(VkDevice device, VkPhysicalDevice physicalDevice, int framesInFlight);
+
+  // the range may only be drawn by command buffers that flushUploads was recorded into first
+  VoxelAllocation allocate(const void *data, VkDeviceSize size);
+  // records the staged copies of every allocation since the last flush, outside of a render pass
+  void flushUploads(VkCommandBuffer commandBuffer, uint64_t frameNumber);
+  // the range stays untouched until every frame recorded before frameNumber has signalled its fence
+  void release(const VoxelAllocation &allocation, uint64_t frameNumber);
+  // called once the fence of frameNumber's slot was waited on
+  void collect(uint64_t frameNumber);
+
+  VkBuffer buffer(int page) const
+  {
+    return pages[page].buffer;
+  }
+
+  VkDeviceSize usedBytes() const
+  {
+    return used;
+  }
+
+  void cleanup();
+
+private:
+  struct Page
+  {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    // nullptr when the page is not host visible and is written through staging
+    char *mapped = nullptr;
+    VkDeviceSize capacity = 0;
+    // offset -> size of every free range, adjacent ranges are merged
+    std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+  };
+
+  struct Staging
+  {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    char *mapped = nullptr;
+    VkDeviceSize capacity = 0;
+    VkDeviceSize used = 0;
+    // copies from it were recorded for frameNumber and may still be running
+    bool inFlight = false;
+    uint64_t frameNumber = 0;
+  };
+
+  struct Upload
+  {
+    int staging;
+    int page;
+    VkBufferCopy region;
+  };
+
+  struct Retired
+  {
+    VoxelAllocation allocation;
+    uint64_t frameNumber;
+  };
+
+  VkDevice device = VK_NULL_HANDLE;
+  VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+  int framesInFlight = 2;
+  std::vector<Page> pages;
+  std::vector<Retired> retired;
+  VkDeviceSize used = 0;
+  std::vector<Staging> stagings;
+  std::vector<Upload> uploads;
+
+  int createPage(VkDeviceSize capacity);
+  void destroyPage(Page &page);
+  int stagingFor(VkDeviceSize size);
+  bool createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &memory);
+  void freeRange(const VoxelAllocation &allocation);
+};
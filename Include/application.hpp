@@ -2,6 +2,7 @@
 #include "engine.hpp"
 #include "primitives.hpp"
 #include <world.hpp>
+#include "frameScheduler.hpp"
 #include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -143,12 +144,46 @@ private:
   glm::vec3 playerVel = glm::vec3(0);
   Inventory inventory;
 
-  World world;
+  World world{0, "saves/0"};
+  // in chunks, chunks past World::lodDistance are meshed at reduced resolution
+  int renderDistance = 24;
+  // chunks stay loaded this many chunks past the loaded square, so walking back and forth over a
+  // chunk border does not unload and reload them; further out they are demoted to World::residency
+  int unloadHysteresis = 4;
   bool leftMouseClick = false;
   bool rightMouseClick = false;
   bool spaceClick = false;
   Engine engine;
 
+  // main thread work past the per frame input and physics, run within a time budget
+  FrameScheduler frameScheduler;
+  std::vector<glm::ivec3> scanPositions;
+  size_t scanIndex = 0;
+  // memory of the chunks in range seen by the current pass, the hot tier of World::residency
+  size_t scanBytes = 0;
+  bool scanFinishedThisFrame = false;
+  std::unordered_set<glm::ivec3, ChunkHasher> pendingUnloads;
+  // chunk offsets of the load square, ring by ring from the center
+  std::vector<glm::ivec2> loadOffsets;
+  size_t loadIndex = 0;
+  glm::ivec3 loadCenter = glm::ivec3(0);
+  // World::chunkChanges when the current pass began
+  uint64_t loadChanges = ~0ull;
+
+  // one extra ring is generated so the chunks at renderDistance have all their side neighbors to be meshed
+  int loadDistance() const
+  {
+    return renderDistance + 1;
+  }
+
+  bool uploadNextMesh(Engine *engine);
+  bool queueMissingChunks(Engine *engine);
+  bool scanLoadedChunks(Engine *engine);
+  bool chunkOutOfRange(Engine *engine, const glm::ivec3 &chunkPos) const;
+  void unloadChunk(Engine *engine, const glm::ivec3 &chunkPos);
+  // once at shutdown, how the world's chunk tiers and chunk I/O did this session
+  void printChunkStats() const;
+
   bool AABBIntersect(glm::vec3 minA, glm::vec3 maxA, glm::vec3 minB, glm::vec3 maxB);
 
   glm::vec3 getPenetration(glm::vec3 minA, glm::vec3 maxA, glm::vec3 minB, glm::vec3 maxB);
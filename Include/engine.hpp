@@ -69,7 +69,8 @@ public:
   }
 
   std::shared_ptr<TextureManager> voxelTextureAtlas;
-  void addVoxelMeshToObject(std::string identifier, MaterialData material, const std::string &texturePath, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices);
+  // replaces the voxel mesh of one section, empty vertices just remove it
+  void setVoxelSectionMesh(std::string identifier, int section, MaterialData material, glm::vec2 tileSize, const std::vector<VoxelVertex> &vertices, bool translucent = false);
 
   void createGameObject(std::string identifier, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale);
   void removeGameObject(std::string identifier);
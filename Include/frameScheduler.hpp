@@ -0,0 +1,51 @@
+#pragma once
+#include <functional>
+#include <deque>
+#include <vector>
+#include <chrono>
+
+// lower values run first
+enum class FramePriority
+{
+  Interface,
+  Upload,
+  Teardown,
+  Background,
+  Count
+};
+
+// Runs main thread work in priority order until the frame budget is spent; whatever is left
+// carries over to the next frame. The first unit of work always runs so nothing starves.
+class FrameScheduler
+{
+public:
+  using Task = std::function<void()>;
+  // does one unit of work, returns false when it has nothing left for this frame
+  using WorkSource = std::function<bool()>;
+
+  float budgetMs = 2.0f;
+
+  // one shot task
+  void schedule(FramePriority priority, Task task);
+  // polled every frame
+  void addSource(FramePriority priority, WorkSource source);
+
+  void runFrame();
+
+  size_t pendingTasks() const;
+
+  float lastFrameMs = 0.0f;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::deque<Task> tasks[static_cast<int>(FramePriority::Count)];
+  std::vector<WorkSource> sources[static_cast<int>(FramePriority::Count)];
+
+  // overruns are summed up and reported at most once a second
+  int overrunFrames = 0;
+  float worstOverrunMs = 0.0f;
+  Clock::time_point lastReport = Clock::now();
+
+  void reportOverrun(float frameMs);
+};
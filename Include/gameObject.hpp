@@ -1,4 +1,5 @@
 #include "mesh.hpp"
+#include "voxelMesh.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -10,6 +11,8 @@ public:
   glm::vec3 rotationZYX;
   glm::vec3 scale = glm::vec3(1.0f);
   std::vector<Mesh> meshes;
+  std::vector<VoxelMesh> voxelMeshes;
+  std::vector<VoxelMesh> translucentVoxelMeshes;
 
   void cleanup(Renderer &renderer);
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <condition_variable>
+
+// Fixed pool of worker threads, each owning a job deque. A worker takes its newest job first and
+// steals the oldest job of another worker when its own deque runs dry; idle workers sleep until
+// a job is submitted or the system shuts down.
+class JobSystem
+{
+public:
+  using Job = std::function<void()>;
+
+  JobSystem() = default;
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  // 0 starts one worker per hardware thread, minus the one running the renderer
+  void start(unsigned workerCount = 0);
+  // stops accepting jobs, lets the workers run every job already queued and joins them
+  void shutdown();
+
+  // jobs submitted from a worker go to its own deque, others are spread round robin;
+  // before start the job runs on the calling thread. Returns false without running the job
+  // once shutdown has begun, the caller keeps whatever the job would have taken over
+  bool submit(Job job);
+
+  unsigned workerCount() const
+  {
+    return static_cast<unsigned>(workers.size());
+  }
+
+private:
+  struct WorkerQueue
+  {
+    std::mutex mtx;
+    std::deque<Job> jobs;
+  };
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> workers;
+
+  // guards the worker list, the deque list, running and stopping. Submits share it while pushing a
+  // job, so shutdown cannot clear the deques under a submit
+  std::shared_mutex stateMutex;
+  bool running = false;
+  bool stopping = false;
+  std::atomic<unsigned> nextQueue = 0;
+
+  // idle workers wait on wake, stopping is also set under sleepMutex so they cannot miss it
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  // jobs sitting in a deque and workers about to wait; a submit that sees no sleeper knows the next
+  // worker to sleep sees its job
+  std::atomic<int> queuedJobs = 0;
+  std::atomic<int> sleepingWorkers = 0;
+
+  void workerLoop(unsigned index);
+  bool takeJob(unsigned index, Job &job);
+};
@@ -16,10 +16,13 @@ struct RenderCommand
 struct Vertex;
 class VulkanDebugDrawer;
 class GameObject;
+class VoxelMesh;
 class Text;
 class Renderer;
 
+RenderCommand makeVoxelFrameCommand(Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj, glm::vec3 viewPos);
 RenderCommand makeGameObjectCommand(GameObject &gameObject, Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj);
+RenderCommand makeTranslucentCommand(GameObject &gameObject, VoxelMesh &mesh, Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj);
 RenderCommand makeUICommand(GameObject &gameObject, Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj);
 RenderCommand makeTextCommand(Text &text, Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj);
 RenderCommand makeDebugCommand(VulkanDebugDrawer *drawer, Renderer *renderer, const std::vector<Vertex> &lines, glm::mat4 view, glm::mat4 proj, int currentFrame);
@@ -15,6 +15,7 @@
 #include "pipelineManager.hpp"
 #include "camera.h"
 #include "bufferManager.hpp"
+#include "voxelArena.hpp"
 #include "mesh.hpp"
 #include "vertex.h"
 #include <ft2build.h>
@@ -44,6 +45,7 @@ class Renderer
 {
 public:
   const int MAX_FRAMES_IN_FLIGHT = 2;
+  const uint32_t INITIAL_QUAD_INDEX_CAPACITY = 1 << 16;
 
   const std::vector<const char *> validationLayers = {
       "VK_LAYER_KHRONOS_validation"};
@@ -82,6 +84,7 @@ public:
   DescriptorManager descriptorManager;
   PipelineManager pipelineManager;
   DeviceManager deviceManager;
+  VoxelArena voxelArena;
 
   VkCommandPool commandPool;
   std::vector<VkCommandBuffer> commandBuffers;
@@ -97,11 +100,14 @@ public:
   void cleanup();
 
   uint32_t getCurrentFrame();
+  // frames submitted so far, voxel ranges released now are reused once this has moved past every frame in flight
+  uint64_t getFrameNumber();
 
 private:
   std::vector<Vertex> vertices;
   std::vector<uint32_t> indices;
   uint32_t currentFrame = 0;
+  uint64_t frameNumber = 0;
 
   void createInstance();
   bool checkValidationLayerSupport();
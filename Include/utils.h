@@ -37,6 +37,14 @@ struct UniformBufferObject
   alignas(16) glm::mat4 proj;
 };
 
+// camera block shared by every voxel mesh in a frame, see shaders/voxel.vert
+struct VoxelFrameUniforms
+{
+  alignas(16) glm::mat4 view;
+  alignas(16) glm::mat4 proj;
+  alignas(16) glm::vec4 viewPos;
+};
+
 QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
 VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkDevice device);
 
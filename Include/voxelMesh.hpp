@@ -0,0 +1,43 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "voxelVertex.h"
+#include "mesh.hpp"
+#include "voxelArena.hpp"
+#include <memory>
+
+struct VoxelPushConstants
+{
+  MaterialData material;
+  glm::vec2 tileSize;
+  // world position of the mesh, voxel meshes only take their object's translation
+  alignas(16) glm::vec3 origin;
+};
+
+class TextureManager;
+class Renderer;
+class VoxelMesh
+{
+public:
+  // CPU copy of the vertices, only kept when the mesh was created with retainVertices
+  std::vector<VoxelVertex> vertices;
+  uint32_t quadCount;
+  // where the vertices live in the renderer's voxel arena
+  VoxelAllocation allocation;
+  // chunk section this mesh was built from, lets a remesh replace only that section
+  int section = -1;
+
+  MaterialData material;
+  glm::vec2 tileSize;
+  // center of the vertex bounds in object space, used to sort translucent meshes
+  glm::vec3 boundsCenter;
+  std::shared_ptr<TextureManager> textureManager;
+
+  VoxelMesh(std::shared_ptr<TextureManager> textureManager, MaterialData newMaterial, glm::vec2 tileSize, const std::vector<VoxelVertex> &vertices, bool retainVertices = false);
+
+  // uploads straight from the caller's vertices, they must be the ones the mesh was created with
+  void initGraphics(Renderer &renderer, const std::vector<VoxelVertex> &vertices);
+  void draw(Renderer *renderer, int currentFrame, glm::vec3 origin, VkCommandBuffer commandBuffer);
+  // hands the vertex range back to the arena once the frames still reading it are done
+  void cleanup(VkDevice device, Renderer &renderer);
+};
\ No newline at end of file
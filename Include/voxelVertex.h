@@ -0,0 +1,79 @@
+#ifndef VOXEL_VERTEX_H
+#define VOXEL_VERTEX_H
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+
+// 8 byte chunk vertex, unpacked in shaders/voxel.vert
+// position: x (5 bits) | y (9 bits) | z (5 bits) | face (3 bits) | corner (2 bits) | ambient occlusion (2 bits)
+// texture:  atlas tile index (8 bits) | repeat u (9 bits) | repeat v (9 bits)
+struct VoxelVertex
+{
+  uint32_t position;
+  uint32_t texture;
+
+  static VoxelVertex pack(glm::ivec3 pos, int face, int corner, int ambientOcclusion, int tileIndex, glm::ivec2 repeatCount)
+  {
+    VoxelVertex vertex;
+    vertex.position = uint32_t(pos.x) | uint32_t(pos.y) << 5 | uint32_t(pos.z) << 14 | uint32_t(face) << 19 | uint32_t(corner) << 22 | uint32_t(ambientOcclusion) << 24;
+    vertex.texture = uint32_t(tileIndex) | uint32_t(repeatCount.x) << 8 | uint32_t(repeatCount.y) << 17;
+    return vertex;
+  }
+
+  glm::ivec3 getPosition() const
+  {
+    return {position & 0x1F, (position >> 5) & 0x1FF, (position >> 14) & 0x1F};
+  }
+
+  int getFace() const
+  {
+    return (position >> 19) & 0x7;
+  }
+
+  int getCorner() const
+  {
+    return (position >> 22) & 0x3;
+  }
+
+  // 0 is fully occluded, 3 is open
+  int getAmbientOcclusion() const
+  {
+    return (position >> 24) & 0x3;
+  }
+
+  int getTileIndex() const
+  {
+    return texture & 0xFF;
+  }
+
+  glm::ivec2 getRepeatCount() const
+  {
+    return {(texture >> 8) & 0x1FF, (texture >> 17) & 0x1FF};
+  }
+
+  static VkVertexInputBindingDescription getBindingDescription()
+  {
+    VkVertexInputBindingDescription bindingDescription{};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = sizeof(VoxelVertex);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return bindingDescription;
+  }
+
+  static std::array<VkVertexInputAttributeDescription, 1> getAttributeDescriptions()
+  {
+    std::array<VkVertexInputAttributeDescription, 1> attributeDescriptions{};
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = VK_FORMAT_R32G32_UINT;
+    attributeDescriptions[0].offset = 0;
+
+    return attributeDescriptions;
+  }
+};
+
+static_assert(sizeof(VoxelVertex) == 8, "VoxelVertex must stay 8 bytes");
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "benchmarkChunks.hpp"
+#include <cstdio>
+
+// Cost of the baked corner occlusion: meshes chunks per biome with and without it. Faces only merge
+// when their corners match, so occlusion also splits quads and adds vertices.
+static const char *biomeNames[] = {"Plains", "Mountain", "Forest"};
+static const size_t chunksPerBiome = 12;
+static const int repeats = 20;
+
+int main()
+{
+  World world;
+  const MeshingMode modes[] = {MeshingMode::Greedy, MeshingMode::Binary};
+  const char *modeNames[] = {"greedy", "binary"};
+  std::printf("ms and vertices per chunk without -> with corner occlusion, %zu chunks per biome, %d runs each\n", chunksPerBiome, repeats);
+
+  for (const char *biomeName : biomeNames)
+  {
+    std::vector<glm::ivec3> chunkPositions = findBiomeChunks(world, biomeName, chunksPerBiome);
+    generateWithNeighbors(world, chunkPositions);
+
+    std::printf("%-8s", biomeName);
+    for (int mode = 0; mode < 2; ++mode)
+    {
+      MeshGenerator generator;
+      generator.meshingMode = modes[mode];
+      double meshMs[2] = {};
+      size_t vertices[2] = {};
+      ChunkNeighborhood neighborhood;
+      for (const glm::ivec3 &chunkPos : chunkPositions)
+      {
+        world.buildNeighborhood(chunkPos, neighborhood);
+        for (int occlusion = 0; occlusion < 2; ++occlusion)
+        {
+          generator.ambientOcclusion = occlusion == 1;
+          auto start = std::chrono::steady_clock::now();
+          for (int run = 0; run < repeats; ++run)
+            generator.generateMesh(neighborhood, world.textureDataSource);
+          meshMs[occlusion] += elapsedMs(start) / repeats;
+          vertices[occlusion] += vertexCount(generator);
+        }
+      }
+      size_t count = chunkPositions.size();
+      std::printf("  %s %.2f -> %.2f (%zu -> %zu)", modeNames[mode], meshMs[0] / count, meshMs[1] / count, vertices[0] / count, vertices[1] / count);
+    }
+    std::printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "world.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// helpers shared by the benchmark programs, they build against tests/engineStubs.cpp
+
+inline double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the first count chunks whose every column lies in the biome, in square rings around the origin
+inline std::vector<glm::ivec3> findBiomeChunks(const World &world, const std::string &biomeName, size_t count)
+{
+  std::vector<glm::ivec3> found;
+  for (int radius = 0; radius < 512 && found.size() < count; ++radius)
+    for (int x = -radius; x <= radius && found.size() < count; ++x)
+      for (int z = -radius; z <= radius && found.size() < count; ++z)
+      {
+        if (std::max(std::abs(x), std::abs(z)) != radius)
+          continue;
+        // chunks three apart, so the picked chunks do not share neighbors
+        glm::ivec3 chunkPos(x * 3 * ChunkData::chunkSize, 0, z * 3 * ChunkData::chunkSize);
+        ChunkColumns columns;
+        world.sampleClimate(chunkPos, columns);
+        bool inBiome = true;
+        for (BiomeId biome : columns.biome)
+          inBiome = inBiome && world.biomes[biome].name == biomeName;
+        if (inBiome)
+          found.push_back(chunkPos);
+      }
+  return found;
+}
+
+// generates the chunks and their eight horizontal neighbors, so every one of them can be meshed
+inline void generateWithNeighbors(World &world, const std::vector<glm::ivec3> &chunkPositions)
+{
+  for (const glm::ivec3 &chunkPos : chunkPositions)
+    for (int dx = -1; dx <= 1; ++dx)
+      for (int dz = -1; dz <= 1; ++dz)
+      {
+        glm::ivec3 pos = chunkPos + glm::ivec3(dx * ChunkData::chunkSize, 0, dz * ChunkData::chunkSize);
+        if (!world.hasChunk(pos))
+          world.generateChunk(pos);
+      }
+}
+
+inline size_t vertexCount(const MeshGenerator &generator)
+{
+  size_t count = 0;
+  for (const SectionMeshData &section : generator.sectionMeshes)
+    count += section.vertices.size() + section.translucentVertices.size();
+  return count;
+}
@@ -0,0 +1,94 @@
+#include "benchmarkChunks.hpp"
+#include "chunkCodec.hpp"
+#include <cstdio>
+#include <random>
+
+// Size and speed of the chunk encoding per biome, against one byte per block and against the memory
+// of the chunk's section palettes, then feeds corrupted encodings to the decoder, which has to reject
+// them or decode them without reading out of bounds (build with -fsanitize=address to check the latter).
+static const char *biomeNames[] = {"Plains", "Ocean", "Forest"};
+static const size_t chunksPerBiome = 32;
+static const int repeats = 20;
+static const int corruptedInputs = 20000;
+
+static bool sameBlocks(const ChunkData &a, const ChunkData &b)
+{
+  for (int x = 0; x < ChunkData::chunkSize; ++x)
+    for (int z = 0; z < ChunkData::chunkSize; ++z)
+      for (int y = 0; y < ChunkData::chunkHeight; ++y)
+        if (a.getBlock(x, y, z) != b.getBlock(x, y, z))
+          return false;
+  return true;
+}
+
+int main()
+{
+  World world;
+  const double blockBytes = ChunkData::chunkSize * ChunkData::chunkSize * ChunkData::chunkHeight;
+  int failures = 0;
+  std::vector<uint8_t> encoded;
+
+  for (const char *biomeName : biomeNames)
+  {
+    std::vector<glm::ivec3> chunkPositions = findBiomeChunks(world, biomeName, chunksPerBiome);
+    size_t encodedBytes = 0;
+    size_t paletteBytes = 0;
+    double generateMs = 0;
+    double encodeMs = 0;
+    double decodeMs = 0;
+    for (const glm::ivec3 &chunkPos : chunkPositions)
+    {
+      auto start = std::chrono::steady_clock::now();
+      world.generateChunk(chunkPos);
+      std::shared_ptr<ChunkData> chunk = world.chunks.at(chunkPos);
+      generateMs += elapsedMs(start);
+
+      paletteBytes += chunk->memoryUsage();
+
+      start = std::chrono::steady_clock::now();
+      for (int run = 0; run < repeats; ++run)
+      {
+        encoded.clear();
+        encodeChunk(*chunk, encoded);
+      }
+      encodeMs += elapsedMs(start) / repeats;
+      encodedBytes += encoded.size();
+
+      ChunkData decoded(chunkPos);
+      bool valid = true;
+      start = std::chrono::steady_clock::now();
+      for (int run = 0; run < repeats; ++run)
+        valid = decodeChunk(encoded.data(), encoded.size(), decoded) && valid;
+      decodeMs += elapsedMs(start) / repeats;
+      if (!valid || !sameBlocks(*chunk, decoded))
+        failures++;
+    }
+
+    double count = static_cast<double>(chunkPositions.size());
+    std::printf("%-7s %4.0f B/chunk, %5.1fx smaller than 1 B/block, %4.1fx than in memory; encode %.3f ms (%.0f MB/s), decode %.3f ms (%.0f MB/s), generate %.2f ms\n", biomeName,
+                encodedBytes / count, blockBytes * count / encodedBytes, static_cast<double>(paletteBytes) / encodedBytes, encodeMs / count, blockBytes * count / encodeMs / 1000,
+                decodeMs / count, blockBytes * count / decodeMs / 1000, generateMs / count);
+  }
+
+  // a few flipped bytes and sometimes a cut off end, the decoder only has to stay in bounds
+  std::mt19937 random(3);
+  std::shared_ptr<ChunkData> chunk = world.chunks.at(findBiomeChunks(world, "Forest", 1).front());
+  encoded.clear();
+  encodeChunk(*chunk, encoded);
+  int rejected = 0;
+  for (int input = 0; input < corruptedInputs; ++input)
+  {
+    std::vector<uint8_t> corrupted = encoded;
+    for (int flips = 1 + random() % 4; flips > 0; --flips)
+      corrupted[random() % corrupted.size()] ^= static_cast<uint8_t>(1 + random() % 255);
+    if (random() % 4 == 0)
+      corrupted.resize(random() % corrupted.size());
+    ChunkData decoded(glm::ivec3(0));
+    rejected += !decodeChunk(corrupted.data(), corrupted.size(), decoded);
+  }
+  std::printf("%d corrupted encodings: %d rejected, the rest decoded\n", corruptedInputs, rejected);
+
+  if (failures > 0)
+    std::printf("%d chunks did not decode to the blocks they were encoded from\n", failures);
+  return failures == 0 ? 0 : 1;
+}
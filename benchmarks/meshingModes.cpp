@@ -0,0 +1,64 @@
+#include "benchmarkChunks.hpp"
+#include <cstdio>
+#include <cstring>
+
+// Meshes the same neighborhoods with the naive, greedy and binary mesher, chunks per biome, and checks
+// that the binary mesher emits exactly the vertices of the greedy one.
+static const char *biomeNames[] = {"Plains", "Mountain", "Forest"};
+static const size_t chunksPerBiome = 12;
+static const int repeats = 20;
+
+static std::vector<VoxelVertex> allVertices(const MeshGenerator &generator)
+{
+  std::vector<VoxelVertex> vertices;
+  for (const SectionMeshData &section : generator.sectionMeshes)
+  {
+    vertices.insert(vertices.end(), section.vertices.begin(), section.vertices.end());
+    vertices.insert(vertices.end(), section.translucentVertices.begin(), section.translucentVertices.end());
+  }
+  return vertices;
+}
+
+int main()
+{
+  World world;
+  const MeshingMode modes[] = {MeshingMode::Naive, MeshingMode::Greedy, MeshingMode::Binary};
+  int failures = 0;
+  std::printf("ms and vertices per chunk, %zu chunks per biome, %d runs each\n", chunksPerBiome, repeats);
+
+  for (const char *biomeName : biomeNames)
+  {
+    std::vector<glm::ivec3> chunkPositions = findBiomeChunks(world, biomeName, chunksPerBiome);
+    generateWithNeighbors(world, chunkPositions);
+
+    MeshGenerator generators[3];
+    double meshMs[3] = {};
+    size_t vertices[3] = {};
+    int mismatches = 0;
+    ChunkNeighborhood neighborhood;
+    for (const glm::ivec3 &chunkPos : chunkPositions)
+    {
+      world.buildNeighborhood(chunkPos, neighborhood);
+      for (int mode = 0; mode < 3; ++mode)
+      {
+        generators[mode].meshingMode = modes[mode];
+        auto start = std::chrono::steady_clock::now();
+        for (int run = 0; run < repeats; ++run)
+          generators[mode].generateMesh(neighborhood, world.textureDataSource);
+        meshMs[mode] += elapsedMs(start) / repeats;
+        vertices[mode] += vertexCount(generators[mode]);
+      }
+
+      std::vector<VoxelVertex> greedy = allVertices(generators[1]);
+      std::vector<VoxelVertex> binary = allVertices(generators[2]);
+      if (greedy.size() != binary.size() || std::memcmp(greedy.data(), binary.data(), greedy.size() * sizeof(VoxelVertex)) != 0)
+        mismatches++;
+    }
+
+    size_t count = chunkPositions.size();
+    std::printf("%-8s naive %.2f (%zu)  greedy %.2f (%zu)  binary %.2f (%zu)  binary differs from greedy in %d of %zu chunks\n", biomeName, meshMs[0] / count, vertices[0] / count,
+                meshMs[1] / count, vertices[1] / count, meshMs[2] / count, vertices[2] / count, mismatches, count);
+    failures += mismatches;
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include "benchmarkChunks.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+// Meshing copies a chunk and its one block border into a ChunkNeighborhood under one World lock and
+// meshes the copy without locks. Times the snapshot and the meshing separately on one thread, then
+// meshes through World from every hardware thread at once: with no lock held while meshing the
+// throughput scales with the threads.
+static const int gridRadius = 4;
+static const int repeats = 10;
+
+int main()
+{
+  World world;
+  std::vector<glm::ivec3> chunkPositions;
+  for (int x = -gridRadius; x <= gridRadius; ++x)
+    for (int z = -gridRadius; z <= gridRadius; ++z)
+      chunkPositions.emplace_back(x * ChunkData::chunkSize, 0, z * ChunkData::chunkSize);
+  generateWithNeighbors(world, chunkPositions);
+
+  int threadCount = std::max(1u, std::thread::hardware_concurrency());
+  std::printf("%zu chunks, %d runs each\n", chunkPositions.size(), repeats);
+
+  const MeshingMode modes[] = {MeshingMode::Naive, MeshingMode::Greedy, MeshingMode::Binary};
+  const char *modeNames[] = {"naive", "greedy", "binary"};
+  for (int mode = 0; mode < 3; ++mode)
+  {
+    MeshGenerator generator;
+    generator.meshingMode = modes[mode];
+    ChunkNeighborhood neighborhood;
+    double snapshotMs = 0;
+    double meshMs = 0;
+    size_t vertices = 0;
+    for (const glm::ivec3 &chunkPos : chunkPositions)
+    {
+      auto start = std::chrono::steady_clock::now();
+      for (int run = 0; run < repeats; ++run)
+        world.buildNeighborhood(chunkPos, neighborhood);
+      snapshotMs += elapsedMs(start);
+
+      start = std::chrono::steady_clock::now();
+      for (int run = 0; run < repeats; ++run)
+        generator.generateMesh(neighborhood, world.textureDataSource);
+      meshMs += elapsedMs(start);
+      vertices += vertexCount(generator);
+    }
+    double chunkRuns = static_cast<double>(chunkPositions.size()) * repeats;
+    double singleRate = chunkRuns / (snapshotMs + meshMs) * 1000;
+
+    // every thread meshes all chunks through World, each with its own generator like the workers
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int thread = 0; thread < threadCount; ++thread)
+    {
+      threads.emplace_back([&]()
+                           {
+                             MeshGenerator threadGenerator;
+                             threadGenerator.meshingMode = modes[mode];
+                             for (int run = 0; run < repeats; ++run)
+                               for (const glm::ivec3 &chunkPos : chunkPositions)
+                                 threadGenerator.generateMesh(&world, world.textureDataSource, world.chunks.at(chunkPos));
+                           });
+    }
+    for (std::thread &thread : threads)
+      thread.join();
+    double threadedRate = chunkRuns * threadCount / elapsedMs(start) * 1000;
+
+    std::printf("%-6s snapshot %.3f ms + mesh %.3f ms per chunk, %zu vertices per chunk; %d threads %.0f chunks/s, %.1fx one thread\n", modeNames[mode],
+                snapshotMs / chunkRuns, meshMs / chunkRuns, vertices / chunkPositions.size(), threadCount, threadedRate, threadedRate / singleRate);
+  }
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include "benchmarkChunks.hpp"
+#include "noise.hpp"
+#include <glm/gtc/noise.hpp>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Times the noise kernels against glm::perlin, one point at a time as generation used to call it, and
+// counts the samples that differ: the batch paths repeat glm's float operations and should match bit
+// for bit, unless the compiler contracts them into fused multiply-adds (-mfma without -ffp-contract=off).
+// Then times the 8 octave height field of a column grid and whole chunk generation.
+static const int sampleCount = 1 << 20;
+static const int gridRepeats = 2000;
+static const int chunkCount = 400;
+
+// the octave loop generation ran per column before the fields were evaluated for the whole grid
+static float referenceOctaves(float x, float y, int octaves, float persistence, float lacunarity, float scale, float amplitude)
+{
+  float frequency = 1.0f;
+  float result = 0.0f;
+  for (int octave = 0; octave < octaves; ++octave)
+  {
+    double angle = octave * 0.5f;
+    float cosA = static_cast<float>(std::cos(angle));
+    float sinA = static_cast<float>(std::sin(angle));
+    float sampleX = (x * cosA - y * sinA) * frequency / scale;
+    float sampleY = (x * sinA + y * cosA) * frequency / scale;
+    result += glm::perlin(glm::vec2(sampleX, sampleY)) * amplitude;
+    amplitude *= persistence;
+    frequency *= lacunarity;
+  }
+  return result;
+}
+
+int main()
+{
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> coordinate(-5000.0f, 5000.0f);
+  std::vector<float> x(sampleCount), y(sampleCount), reference(sampleCount), result(sampleCount);
+  for (int i = 0; i < sampleCount; ++i)
+  {
+    x[i] = coordinate(random);
+    y[i] = coordinate(random);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < sampleCount; ++i)
+    reference[i] = glm::perlin(glm::vec2(x[i], y[i]));
+  double glmMs = elapsedMs(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < sampleCount; ++i)
+    result[i] = perlinNoise(x[i], y[i]);
+  double scalarMs = elapsedMs(start);
+  int scalarMismatches = 0;
+  for (int i = 0; i < sampleCount; ++i)
+    scalarMismatches += result[i] != reference[i];
+
+  start = std::chrono::steady_clock::now();
+  perlinNoiseBatch(x.data(), y.data(), result.data(), sampleCount);
+  double batchMs = elapsedMs(start);
+  int batchMismatches = 0;
+  float maxDifference = 0.0f;
+  for (int i = 0; i < sampleCount; ++i)
+  {
+    batchMismatches += result[i] != reference[i];
+    maxDifference = std::max(maxDifference, std::abs(result[i] - reference[i]));
+  }
+
+#if defined(__AVX2__)
+  const char *lanes = "AVX2";
+#elif defined(__SSE2__)
+  const char *lanes = "SSE2";
+#else
+  const char *lanes = "scalar";
+#endif
+  std::printf("%d samples, ns per sample: glm::perlin %.1f, perlinNoise %.1f (%d differ), perlinNoiseBatch %s %.1f (%d differ, max %g)\n", sampleCount, glmMs * 1e6 / sampleCount,
+              scalarMs * 1e6 / sampleCount, scalarMismatches, lanes, batchMs * 1e6 / sampleCount, batchMismatches, maxDifference);
+
+  // the height field of one chunk: 256 columns, 8 octaves, scale, persistence and amplitude per column
+  const int columnCount = ChunkData::chunkSize * ChunkData::chunkSize;
+  float columnX[columnCount], columnZ[columnCount], scales[columnCount], persistences[columnCount], amplitudes[columnCount];
+  float gridReference[columnCount], gridResult[columnCount];
+  for (int column = 0; column < columnCount; ++column)
+  {
+    columnX[column] = static_cast<float>(column / ChunkData::chunkSize);
+    columnZ[column] = static_cast<float>(column % ChunkData::chunkSize);
+    scales[column] = 300.0f + column;
+    persistences[column] = 0.4f + column * 0.001f;
+    amplitudes[column] = 5.0f + column * 0.4f;
+  }
+  double referenceMs = 0;
+  double gridMs = 0;
+  int gridMismatches = 0;
+  for (int run = 0; run < gridRepeats; ++run)
+  {
+    // a different chunk every run, like generation walking the world
+    float offsetX = static_cast<float>((run % 50) * ChunkData::chunkSize);
+    float offsetZ = static_cast<float>((run / 50) * ChunkData::chunkSize);
+    float gridX[columnCount], gridZ[columnCount];
+    for (int column = 0; column < columnCount; ++column)
+    {
+      gridX[column] = columnX[column] + offsetX;
+      gridZ[column] = columnZ[column] + offsetZ;
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (int column = 0; column < columnCount; ++column)
+      gridReference[column] = referenceOctaves(gridX[column], gridZ[column], 8, persistences[column], 2.0f, scales[column], amplitudes[column]);
+    referenceMs += elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    fractalNoiseBatch(gridX, gridZ, columnCount, 8, 2.0f, scales, persistences, amplitudes, gridResult);
+    gridMs += elapsedMs(start);
+    for (int column = 0; column < columnCount; ++column)
+      gridMismatches += gridResult[column] != gridReference[column];
+  }
+  std::printf("8 octave height field, ms per chunk: per column %.3f, fractalNoiseBatch %.3f (%d of %d columns differ)\n", referenceMs / gridRepeats, gridMs / gridRepeats, gridMismatches,
+              gridRepeats * columnCount);
+
+  World world;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < chunkCount; ++i)
+    world.generateChunk(glm::ivec3((i % 20) * ChunkData::chunkSize, 0, (i / 20) * ChunkData::chunkSize));
+  std::printf("%d chunks generated, %.0f chunks/s\n", chunkCount, chunkCount / elapsedMs(start) * 1000);
+  return 0;
+}
@@ -1,3 +1,5 @@
 C:/VulkanSDK/1.3.290.0/Bin/glslc.exe shader.vert -o vert.spv
 C:/VulkanSDK/1.3.290.0/Bin/glslc.exe shader.frag -o frag.spv
+C:/VulkanSDK/1.3.290.0/Bin/glslc.exe voxel.vert -o voxelVert.spv
+C:/VulkanSDK/1.3.290.0/Bin/glslc.exe voxel.frag -o voxelFrag.spv
 pause
\ No newline at end of file
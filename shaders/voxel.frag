@@ -0,0 +1,50 @@
+#version 450
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 diffuseColor;
+layout(location = 2) in vec3 fragNormal;
+layout(location = 3) in vec3 viewPos;
+layout(location = 4) in vec3 fragPos;
+layout(location = 5) flat in vec2 tileStart;
+layout(location = 6) flat in vec2 repeatCount;
+
+layout(push_constant) uniform VoxelPushConstants {
+    vec3 ambientColor;
+    vec3 diffuseColor;
+    vec3 specularColor;
+    vec3 emissionColor;
+    float shininess;
+    float opacity;
+    float refractiveIndex;
+    int illuminationModel;
+    int hasTexture;
+    vec2 tileSize;
+} material;
+
+layout(location = 0) out vec4 outColor;
+
+layout(binding = 1) uniform sampler2D texSampler;
+
+void main() {
+    vec2 tiledUV = fract(fragTexCoord * repeatCount);
+    vec2 finalUV = tileStart + tiledUV * material.tileSize;
+
+    vec3 norm = normalize(fragNormal);
+    vec3 lightDir = normalize(-vec3(-0.5, -1.0, -0.3));
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * vec3(1.0, 1.0, 0.9);
+
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = 0.0;
+    if(diff > 0.0)
+        spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = material.specularColor * spec * vec3(1.0, 1.0, 0.9);
+
+    vec3 ambient = 0.3 * vec3(1.0, 1.0, 0.9);
+
+    vec3 litColor = diffuseColor.rgb * (ambient + diffuse + specular);
+
+    vec4 texColor = texture(texSampler, finalUV);
+    outColor = vec4(litColor * texColor.rgb, texColor.a * material.opacity);
+}
\ No newline at end of file
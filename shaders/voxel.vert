@@ -0,0 +1,71 @@
+#version 450
+
+// shared by every voxel mesh, see VoxelFrameUniforms in Include/utils.h
+layout(binding = 0) uniform VoxelFrameUniforms {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+} frame;
+
+layout(push_constant) uniform VoxelPushConstants {
+    vec3 ambientColor;
+    vec3 diffuseColor;
+    vec3 specularColor;
+    vec3 emissionColor;
+    float shininess;
+    float opacity;
+    float refractiveIndex;
+    int illuminationModel;
+    int hasTexture;
+    vec2 tileSize;
+    vec3 origin;
+} material;
+
+// see VoxelVertex in Include/voxelVertex.h for the bit layout
+layout(location = 0) in uvec2 inPacked;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 diffuseColor;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec3 viewPos;
+layout(location = 4) out vec3 fragPos;
+
+layout(location = 5) flat out vec2 tileStart;
+layout(location = 6) flat out vec2 repeatCount;
+
+const vec3 faceNormals[6] = vec3[](
+    vec3(1, 0, 0), vec3(-1, 0, 0),
+    vec3(0, 1, 0), vec3(0, -1, 0),
+    vec3(0, 0, 1), vec3(0, 0, -1));
+
+// brightness for each baked ambient occlusion level, 0 is fully occluded
+const float aoCurve[4] = float[](0.45, 0.6, 0.8, 1.0);
+
+// texture coordinate of each quad corner, faces 0-3 and faces 4-5 wind differently
+const vec2 cornerUVs[8] = vec2[](
+    vec2(0, 1), vec2(0, 0), vec2(1, 0), vec2(1, 1),
+    vec2(0, 1), vec2(1, 1), vec2(1, 0), vec2(0, 0));
+
+void main() {
+    uint position = inPacked.x;
+    uint packedTexture = inPacked.y;
+
+    vec3 localPos = vec3(position & 0x1Fu, (position >> 5) & 0x1FFu, (position >> 14) & 0x1Fu);
+    uint face = (position >> 19) & 0x7u;
+    uint corner = (position >> 22) & 0x3u;
+    uint ambientOcclusion = (position >> 24) & 0x3u;
+
+    uint tileIndex = packedTexture & 0xFFu;
+    repeatCount = vec2((packedTexture >> 8) & 0x1FFu, (packedTexture >> 17) & 0x1FFu);
+
+    uint tilesPerRow = uint(round(1.0 / material.tileSize.x));
+    tileStart = vec2(tileIndex % tilesPerRow, tileIndex / tilesPerRow) * material.tileSize;
+    fragTexCoord = cornerUVs[(face >= 4u ? 4u : 0u) + corner];
+
+    vec3 worldPos = material.origin + localPos;
+    gl_Position = frame.proj * frame.view * vec4(worldPos, 1.0);
+    diffuseColor = vec4(material.diffuseColor * aoCurve[ambientOcclusion], 1);
+    fragNormal = faceNormals[face];
+    viewPos = frame.viewPos.xyz;
+    fragPos = worldPos;
+}
\ No newline at end of file
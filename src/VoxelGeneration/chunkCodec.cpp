@@ -0,0 +1,273 @@
+#include "chunkCodec.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  const int columnCount = ChunkData::chunkSize * ChunkData::chunkSize;
+  const int sectionBlocks = ChunkData::chunkSize * ChunkData::chunkSize * ChunkData::sectionHeight;
+
+  const size_t minMatch = 4;
+  const size_t maxOffset = 0xFFFF;
+  const int hashBits = 12;
+
+  uint32_t load32(const uint8_t *p)
+  {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  size_t hash4(const uint8_t *p)
+  {
+    return (load32(p) * 2654435761u) >> (32 - hashBits);
+  }
+
+  void writeLength(std::vector<uint8_t> &out, size_t length)
+  {
+    while (length >= 255)
+    {
+      out.push_back(255);
+      length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+  }
+
+  bool readLength(const uint8_t *&cursor, const uint8_t *end, size_t &length)
+  {
+    uint8_t byte;
+    do
+    {
+      if (cursor == end)
+        return false;
+      byte = *cursor++;
+      length += byte;
+    } while (byte == 255);
+    return true;
+  }
+
+  void writeSequence(std::vector<uint8_t> &out, const uint8_t *literals, size_t literalCount, size_t matchLength, size_t offset)
+  {
+    size_t matchCode = matchLength >= minMatch ? matchLength - minMatch : 0;
+    out.push_back(static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4 | std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15)
+      writeLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    if (matchLength < minMatch)
+      return;
+
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= 15)
+      writeLength(out, matchCode - 15);
+  }
+}
+
+void lzCompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    out.push_back(static_cast<uint8_t>(size >> (i * 8)));
+  }
+
+  // last position a match was seen for each hash of the next four bytes
+  uint32_t table[1 << hashBits];
+  std::fill(std::begin(table), std::end(table), 0);
+
+  size_t literalStart = 0;
+  size_t position = 0;
+  while (size >= minMatch && position <= size - minMatch)
+  {
+    size_t hash = hash4(data + position);
+    size_t candidate = table[hash];
+    table[hash] = static_cast<uint32_t>(position);
+
+    if (candidate >= position || position - candidate > maxOffset || load32(data + candidate) != load32(data + position))
+    {
+      position++;
+      continue;
+    }
+
+    size_t matchLength = minMatch;
+    while (position + matchLength < size && data[candidate + matchLength] == data[position + matchLength])
+      matchLength++;
+
+    writeSequence(out, data + literalStart, position - literalStart, matchLength, position - candidate);
+    position += matchLength;
+    literalStart = position;
+  }
+
+  writeSequence(out, data + literalStart, size - literalStart, 0, 0);
+}
+
+bool lzDecompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+  if (size < 4)
+    return false;
+  size_t outSize = static_cast<size_t>(data[0]) | static_cast<size_t>(data[1]) << 8 | static_cast<size_t>(data[2]) << 16 | static_cast<size_t>(data[3]) << 24;
+  const uint8_t *cursor = data + 4;
+  const uint8_t *end = data + size;
+
+  out.resize(outSize);
+  size_t position = 0;
+  while (cursor < end)
+  {
+    uint8_t token = *cursor++;
+    size_t literalCount = token >> 4;
+    if (literalCount == 15 && !readLength(cursor, end, literalCount))
+      return false;
+    if (literalCount > static_cast<size_t>(end - cursor) || literalCount > outSize - position)
+      return false;
+    std::memcpy(out.data() + position, cursor, literalCount);
+    cursor += literalCount;
+    position += literalCount;
+
+    // the last sequence ends after its literals
+    if (cursor == end)
+      break;
+
+    if (end - cursor < 2)
+      return false;
+    size_t offset = static_cast<size_t>(cursor[0]) | static_cast<size_t>(cursor[1]) << 8;
+    cursor += 2;
+    size_t matchLength = token & 15;
+    if (matchLength == 15 && !readLength(cursor, end, matchLength))
+      return false;
+    matchLength += minMatch;
+    if (offset == 0 || offset > position || matchLength > outSize - position)
+      return false;
+
+    // matches may overlap their own output, byte by byte copies the repeated pattern
+    uint8_t *target = out.data() + position;
+    const uint8_t *source = target - offset;
+    for (size_t i = 0; i < matchLength; i++)
+    {
+      target[i] = source[i];
+    }
+    position += matchLength;
+  }
+  return position == outSize;
+}
+
+void encodeChunk(const ChunkData &chunk, std::vector<uint8_t> &out)
+{
+  std::vector<uint8_t> runs;
+  runs.reserve(columnCount * 8);
+  BlockType column[ChunkData::chunkHeight];
+  for (int x = 0; x < ChunkData::chunkSize; x++)
+  {
+    for (int z = 0; z < ChunkData::chunkSize; z++)
+    {
+      for (int section = 0; section < ChunkData::sectionCount; section++)
+      {
+        const PaletteStorage &storage = chunk.sections[section];
+        int bottom = section * ChunkData::sectionHeight;
+        if (storage.isUniform())
+        {
+          std::fill(column + bottom, column + bottom + ChunkData::sectionHeight, storage.getUniformBlock());
+          continue;
+        }
+        for (int y = 0; y < ChunkData::sectionHeight; y++)
+        {
+          column[bottom + y] = storage.get(chunk.toSectionIndex(x, y, z));
+        }
+      }
+
+      int start = 0;
+      for (int y = 1; y <= ChunkData::chunkHeight; y++)
+      {
+        if (y == ChunkData::chunkHeight || column[y] != column[start])
+        {
+          runs.push_back(static_cast<uint8_t>(column[start]));
+          runs.push_back(static_cast<uint8_t>(y - start - 1));
+          start = y;
+        }
+      }
+    }
+  }
+
+  lzCompress(runs.data(), runs.size(), out);
+}
+
+bool decodeChunk(const uint8_t *data, size_t size, ChunkData &chunk)
+{
+  std::vector<uint8_t> runs;
+  if (!lzDecompress(data, size, runs))
+    return false;
+
+  // checks the runs and their types and collects the block types present in every section
+  size_t columnStart[columnCount + 1];
+  uint64_t present[ChunkData::sectionCount][4] = {};
+  size_t cursor = 0;
+  for (int column = 0; column < columnCount; column++)
+  {
+    columnStart[column] = cursor;
+    int y = 0;
+    while (y < ChunkData::chunkHeight)
+    {
+      if (cursor + 2 > runs.size())
+        return false;
+      uint8_t type = runs[cursor];
+      int runEnd = y + runs[cursor + 1] + 1;
+      cursor += 2;
+      // an unknown type would index past the per-type tables of the mesher
+      if (runEnd > ChunkData::chunkHeight || type > static_cast<uint8_t>(BlockType::Tree_Leafes_Solid))
+        return false;
+
+      for (int section = y / ChunkData::sectionHeight; section <= (runEnd - 1) / ChunkData::sectionHeight; section++)
+      {
+        present[section][type >> 6] |= uint64_t(1) << (type & 63);
+      }
+      y = runEnd;
+    }
+  }
+  columnStart[columnCount] = cursor;
+  if (cursor != runs.size())
+    return false;
+
+  // most sections hold a single block type, only the others are written block by block and packed
+  BlockType blocks[sectionBlocks];
+  for (int section = 0; section < ChunkData::sectionCount; section++)
+  {
+    int typeCount = 0;
+    int lastType = 0;
+    for (int word = 0; word < 4; word++)
+    {
+      for (uint64_t bits = present[section][word]; bits != 0; bits &= bits - 1)
+      {
+        typeCount++;
+        lastType = word * 64 + __builtin_ctzll(bits);
+      }
+    }
+
+    if (typeCount == 1)
+    {
+      chunk.sections[section].fill(static_cast<BlockType>(lastType));
+      continue;
+    }
+
+    int bottom = section * ChunkData::sectionHeight;
+    int top = bottom + ChunkData::sectionHeight;
+    for (int x = 0; x < ChunkData::chunkSize; x++)
+    {
+      for (int z = 0; z < ChunkData::chunkSize; z++)
+      {
+        int column = x * ChunkData::chunkSize + z;
+        int y = 0;
+        for (size_t run = columnStart[column]; run < columnStart[column + 1] && y < top; run += 2)
+        {
+          int runEnd = y + runs[run + 1] + 1;
+          BlockType type = static_cast<BlockType>(runs[run]);
+          for (int blockY = std::max(y, bottom); blockY < std::min(runEnd, top); blockY++)
+          {
+            blocks[chunk.toSectionIndex(x, blockY, z)] = type;
+          }
+          y = runEnd;
+        }
+      }
+    }
+    chunk.sections[section].assign(blocks);
+  }
+  chunk.dirtySections = ChunkData::allSections;
+  return true;
+}
@@ -1,6 +1,22 @@
 #include "chunkData.hpp"
 
-ChunkData::ChunkData(glm::ivec3 worldPosition) : worldPosition(worldPosition)
+ChunkData::ChunkData(glm::ivec3 worldPosition) : sections(sectionCount, PaletteStorage(chunkSize * chunkSize * sectionHeight, BlockType::Nothing)), worldPosition(worldPosition)
 {
-  std::fill(std::begin(blocks), std::end(blocks), BlockType::Nothing);
-}
\ No newline at end of file
+}
+
+void ChunkData::fill(BlockType type)
+{
+  for (PaletteStorage &section : sections)
+  {
+    section.fill(type);
+  }
+  dirtySections = allSections;
+}
+
+void ChunkData::compact()
+{
+  for (PaletteStorage &section : sections)
+  {
+    section.compact();
+  }
+}
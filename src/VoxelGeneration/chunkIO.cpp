@@ -0,0 +1,483 @@
+#include "chunkIO.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CHUNK_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  class ThreadPoolBackend : public IOBackend
+  {
+  public:
+    explicit ThreadPoolBackend(unsigned threadCount)
+    {
+      for (unsigned i = 0; i < std::max(threadCount, 1u); i++)
+      {
+        threads.emplace_back([this]()
+                             { threadLoop(); });
+      }
+    }
+
+    ~ThreadPoolBackend() override
+    {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+      }
+      work.notify_all();
+      for (std::thread &thread : threads)
+      {
+        thread.join();
+      }
+    }
+
+    const char *name() const override
+    {
+      return "thread pool";
+    }
+
+    int open(const std::string &path) override
+    {
+      auto file = std::make_shared<File>();
+      file->stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+      if (!file->stream.is_open())
+      {
+        std::ofstream create(path, std::ios::binary);
+        create.close();
+        file->stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+      }
+      if (!file->stream.is_open())
+        return -1;
+
+      // handles of closed files are reused
+      for (size_t i = 0; i < files.size(); i++)
+      {
+        if (!files[i])
+        {
+          files[i] = std::move(file);
+          return static_cast<int>(i);
+        }
+      }
+      files.push_back(std::move(file));
+      return static_cast<int>(files.size() - 1);
+    }
+
+    void close(int file) override
+    {
+      // requests still running hold their own reference
+      files[file].reset();
+    }
+
+    int64_t fileSize(int file) override
+    {
+      File &target = *files[file];
+      std::lock_guard<std::mutex> lock(target.mtx);
+      target.stream.seekg(0, std::ios::end);
+      int64_t size = static_cast<int64_t>(target.stream.tellg());
+      target.stream.clear();
+      return size;
+    }
+
+    bool readNow(int file, uint64_t offset, uint8_t *data, uint32_t size) override
+    {
+      return transfer(*files[file], false, offset, data, size) == size;
+    }
+
+    bool writeNow(int file, uint64_t offset, const uint8_t *data, uint32_t size) override
+    {
+      return transfer(*files[file], true, offset, const_cast<uint8_t *>(data), size) == size;
+    }
+
+    void submit(std::vector<IORequest> &requests) override
+    {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (IORequest &request : requests)
+        {
+          jobs.push_back({files[request.file], std::move(request)});
+        }
+      }
+      requests.clear();
+      work.notify_all();
+    }
+
+    void complete(bool wait) override
+    {
+      std::vector<Finished> done;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (wait)
+          finishedChanged.wait(lock, [this]()
+                               { return !finished.empty() || woken; });
+        woken = false;
+        done.swap(finished);
+      }
+
+      for (Finished &request : done)
+      {
+        request.request.complete(request.result);
+      }
+    }
+
+    void wake() override
+    {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        woken = true;
+      }
+      finishedChanged.notify_one();
+    }
+
+  private:
+    // a stream has one position, so requests on the same file take turns
+    struct File
+    {
+      std::mutex mtx;
+      std::fstream stream;
+    };
+
+    struct Job
+    {
+      std::shared_ptr<File> file;
+      IORequest request;
+    };
+
+    struct Finished
+    {
+      IORequest request;
+      int64_t result;
+    };
+
+    // only touched by the I/O thread
+    std::vector<std::shared_ptr<File>> files;
+
+    // guards jobs, finished, woken and stopping
+    std::mutex mtx;
+    std::condition_variable work;
+    std::condition_variable finishedChanged;
+    std::deque<Job> jobs;
+    std::vector<Finished> finished;
+    bool woken = false;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    static int64_t transfer(File &file, bool write, uint64_t offset, uint8_t *data, uint32_t size)
+    {
+      std::lock_guard<std::mutex> lock(file.mtx);
+      std::fstream &stream = file.stream;
+      if (write)
+      {
+        stream.seekp(static_cast<std::streamoff>(offset));
+        stream.write(reinterpret_cast<const char *>(data), size);
+        stream.flush();
+      }
+      else
+      {
+        stream.seekg(static_cast<std::streamoff>(offset));
+        stream.read(reinterpret_cast<char *>(data), size);
+      }
+
+      if (!stream)
+      {
+        stream.clear();
+        return -1;
+      }
+      return size;
+    }
+
+    void threadLoop()
+    {
+      while (true)
+      {
+        Job job;
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          work.wait(lock, [this]()
+                    { return stopping || !jobs.empty(); });
+          if (jobs.empty())
+            return;
+          job = std::move(jobs.front());
+          jobs.pop_front();
+        }
+
+        int64_t result = transfer(*job.file, job.request.write, job.request.offset, job.request.data, job.request.size);
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          finished.push_back({std::move(job.request), result});
+        }
+        finishedChanged.notify_one();
+      }
+    }
+  };
+
+#if defined(CHUNK_IO_URING)
+  // io_uring through the raw system calls, so no liburing is needed. Requests beyond the ring size
+  // wait in a backlog, a read of an eventfd is kept in the ring while waiting so wake can interrupt it
+  class UringBackend : public IOBackend
+  {
+  public:
+    ~UringBackend() override
+    {
+      if (sqes)
+        munmap(sqes, sqesSize);
+      if (cqRing && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+      if (sqRing)
+        munmap(sqRing, sqRingSize);
+      if (ringFd >= 0)
+        ::close(ringFd);
+      if (wakeFd >= 0)
+        ::close(wakeFd);
+      for (Pending *pending : backlog)
+      {
+        delete pending;
+      }
+    }
+
+    bool setup(unsigned queueDepth)
+    {
+      io_uring_params params = {};
+      ringFd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+      if (ringFd < 0)
+        return false;
+
+      sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+      if (singleMap)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+      sqRing = map(sqRingSize, IORING_OFF_SQ_RING);
+      cqRing = singleMap ? sqRing : map(cqRingSize, IORING_OFF_CQ_RING);
+      sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+      sqes = static_cast<io_uring_sqe *>(map(sqesSize, IORING_OFF_SQES));
+      wakeFd = eventfd(0, EFD_CLOEXEC);
+      if (!sqRing || !cqRing || !sqes || wakeFd < 0)
+        return false;
+
+      uint8_t *sq = static_cast<uint8_t *>(sqRing);
+      sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+      sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+      sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+      sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+      uint8_t *cq = static_cast<uint8_t *>(cqRing);
+      cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+      cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+      cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+      cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+      sqEntries = params.sq_entries;
+      return true;
+    }
+
+    const char *name() const override
+    {
+      return "io_uring";
+    }
+
+    int open(const std::string &path) override
+    {
+      return ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    }
+
+    void close(int file) override
+    {
+      ::close(file);
+    }
+
+    int64_t fileSize(int file) override
+    {
+      struct stat status;
+      return fstat(file, &status) == 0 ? static_cast<int64_t>(status.st_size) : -1;
+    }
+
+    bool readNow(int file, uint64_t offset, uint8_t *data, uint32_t size) override
+    {
+      return pread(file, data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+    }
+
+    bool writeNow(int file, uint64_t offset, const uint8_t *data, uint32_t size) override
+    {
+      return pwrite(file, data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+    }
+
+    void submit(std::vector<IORequest> &requests) override
+    {
+      for (IORequest &request : requests)
+      {
+        Pending *pending = new Pending{std::move(request), {}};
+        pending->vector = {pending->request.data, pending->request.size};
+        backlog.push_back(pending);
+      }
+      requests.clear();
+      fillRing();
+    }
+
+    void complete(bool wait) override
+    {
+      if (wait)
+      {
+        if (!wakeArmed)
+          wakeArmed = push(IORING_OP_READV, wakeFd, &wakeVector, 0, 0);
+        enter(1, IORING_ENTER_GETEVENTS);
+      }
+
+      // the ring slots are handed back before the callbacks run, they may submit more requests
+      done.clear();
+      unsigned head = *cqHead;
+      unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+      for (; head != tail; head++)
+      {
+        const io_uring_cqe &cqe = cqes[head & cqMask];
+        if (cqe.user_data == 0)
+        {
+          wakeArmed = false;
+          continue;
+        }
+        done.push_back({reinterpret_cast<Pending *>(static_cast<uintptr_t>(cqe.user_data)), cqe.res});
+        inFlight--;
+      }
+      __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+      for (auto &[pending, result] : done)
+      {
+        pending->request.complete(result);
+        delete pending;
+      }
+      fillRing();
+    }
+
+    void wake() override
+    {
+      uint64_t one = 1;
+      ssize_t written = write(wakeFd, &one, sizeof(one));
+      (void)written;
+    }
+
+  private:
+    struct Pending
+    {
+      IORequest request;
+      iovec vector;
+    };
+
+    int ringFd = -1;
+    int wakeFd = -1;
+    void *sqRing = nullptr;
+    void *cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    unsigned cqMask = 0;
+
+    // filled in the ring but not yet passed to the kernel
+    unsigned unsubmitted = 0;
+    // passed to the kernel, not counting the wake read
+    unsigned inFlight = 0;
+    std::deque<Pending *> backlog;
+    std::vector<std::pair<Pending *, int64_t>> done;
+
+    uint64_t wakeValue = 0;
+    iovec wakeVector = {&wakeValue, sizeof(wakeValue)};
+    bool wakeArmed = false;
+
+    void *map(size_t size, uint64_t offset)
+    {
+      void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, static_cast<off_t>(offset));
+      return memory == MAP_FAILED ? nullptr : memory;
+    }
+
+    bool push(uint8_t opcode, int fd, iovec *vector, uint64_t offset, uint64_t userData)
+    {
+      unsigned tail = *sqTail;
+      if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+        return false;
+
+      unsigned index = tail & sqMask;
+      io_uring_sqe &sqe = sqes[index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = opcode;
+      sqe.fd = fd;
+      sqe.addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(vector));
+      sqe.len = 1;
+      sqe.off = offset;
+      sqe.user_data = userData;
+      sqArray[index] = index;
+      __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+      unsubmitted++;
+      return true;
+    }
+
+    // moves backlog into the ring, one slot stays free for the wake read so completions never overflow
+    void fillRing()
+    {
+      while (!backlog.empty() && inFlight + 1 < sqEntries)
+      {
+        Pending *pending = backlog.front();
+        if (!push(pending->request.write ? IORING_OP_WRITEV : IORING_OP_READV, pending->request.file, &pending->vector, pending->request.offset, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pending))))
+          break;
+        backlog.pop_front();
+        inFlight++;
+      }
+      if (unsubmitted > 0)
+        enter(0, 0);
+    }
+
+    void enter(unsigned minComplete, unsigned flags)
+    {
+      while (true)
+      {
+        long result = syscall(__NR_io_uring_enter, ringFd, unsubmitted, minComplete, flags, nullptr, 0);
+        if (result >= 0)
+        {
+          unsubmitted -= static_cast<unsigned>(result);
+          return;
+        }
+        if (errno != EINTR)
+          return;
+      }
+    }
+  };
+#endif
+}
+
+std::unique_ptr<IOBackend> createUringBackend(unsigned queueDepth)
+{
+#if defined(CHUNK_IO_URING)
+  auto backend = std::make_unique<UringBackend>();
+  if (backend->setup(queueDepth))
+    return backend;
+#else
+  (void)queueDepth;
+#endif
+  return nullptr;
+}
+
+std::unique_ptr<IOBackend> createThreadPoolBackend(unsigned threadCount)
+{
+  return std::make_unique<ThreadPoolBackend>(threadCount);
+}
@@ -0,0 +1,104 @@
+#include "chunkNeighborhood.hpp"
+#include "meshGenerator.hpp"
+#include <algorithm>
+
+void ChunkNeighborhood::clear(glm::ivec3 newWorldPosition)
+{
+  worldPosition = newWorldPosition;
+  std::fill(blocks.begin(), blocks.end(), BlockType::Nothing);
+  std::fill(std::begin(sectionEmpty), std::end(sectionEmpty), true);
+  lodLevel = 0;
+}
+
+void ChunkNeighborhood::copyFrom(const ChunkData &chunk, int srcX0, int srcZ0, int dstX0, int dstZ0, int width, int depth)
+{
+  for (int section = 0; section < ChunkData::sectionCount; ++section)
+  {
+    const PaletteStorage &storage = chunk.sections[section];
+    int sectionBottom = section * ChunkData::sectionHeight;
+
+    if (storage.isUniform())
+    {
+      BlockType block = storage.getUniformBlock();
+      for (int y = sectionBottom; y < sectionBottom + ChunkData::sectionHeight; ++y)
+        for (int z = 0; z < depth; ++z)
+        {
+          BlockType *row = &blocks[toIndex(dstX0, y, dstZ0 + z)];
+          std::fill(row, row + width, block);
+        }
+      continue;
+    }
+
+    for (int y = sectionBottom; y < sectionBottom + ChunkData::sectionHeight; ++y)
+      for (int z = 0; z < depth; ++z)
+      {
+        BlockType *row = &blocks[toIndex(dstX0, y, dstZ0 + z)];
+        for (int x = 0; x < width; ++x)
+        {
+          row[x] = storage.get(chunk.toSectionIndex(srcX0 + x, y, srcZ0 + z));
+        }
+      }
+  }
+}
+
+void ChunkNeighborhood::copyCoarseFrom(const ChunkData &chunk, int lodLevel, int srcX0, int srcZ0, int dstX0, int dstZ0, int width, int depth)
+{
+  int scale = 1 << lodLevel;
+  for (int section = 0; section < ChunkData::sectionCount; ++section)
+  {
+    const PaletteStorage &storage = chunk.sections[section];
+    int sectionBottom = section * ChunkData::sectionHeight;
+
+    if (storage.isUniform())
+    {
+      BlockType block = storage.getUniformBlock();
+      for (int y = sectionBottom; y < sectionBottom + ChunkData::sectionHeight; ++y)
+        for (int z = 0; z < depth; ++z)
+        {
+          BlockType *row = &blocks[toIndex(dstX0, y, dstZ0 + z)];
+          std::fill(row, row + width, block);
+        }
+      continue;
+    }
+
+    // the area is one block thick across the border, so each cell it touches is voted once and fills
+    // up to scale blocks along the border
+    for (int cellY = sectionBottom; cellY < sectionBottom + ChunkData::sectionHeight; cellY += scale)
+      for (int z = 0; z < depth; z += std::min(scale, depth))
+        for (int x = 0; x < width; x += std::min(scale, width))
+        {
+          int cellX = (srcX0 + x) / scale * scale;
+          int cellZ = (srcZ0 + z) / scale * scale;
+
+          int counts[blockTypeCount] = {};
+          for (int y = cellY; y < cellY + scale; ++y)
+            for (int cz = cellZ; cz < cellZ + scale; ++cz)
+              for (int cx = cellX; cx < cellX + scale; ++cx)
+                counts[static_cast<int>(storage.get(chunk.toSectionIndex(cx, y, cz)))]++;
+          BlockType majority = majorityBlock(counts);
+
+          for (int y = cellY; y < cellY + scale; ++y)
+            for (int fz = z; fz < std::min(z + scale, depth); ++fz)
+            {
+              BlockType *row = &blocks[toIndex(dstX0 + x, y, dstZ0 + fz)];
+              std::fill(row, row + std::min(scale, width - x), majority);
+            }
+        }
+  }
+}
+
+BlockType ChunkNeighborhood::majorityBlock(const int (&counts)[blockTypeCount])
+{
+  BlockType majority = BlockType::Air;
+  int majorityCount = -1;
+  for (int type = 0; type < blockTypeCount; ++type)
+  {
+    BlockType block = static_cast<BlockType>(type);
+    if (counts[type] > majorityCount || (counts[type] == majorityCount && isOccluder(block) && !isOccluder(majority)))
+    {
+      majority = block;
+      majorityCount = counts[type];
+    }
+  }
+  return majority;
+}
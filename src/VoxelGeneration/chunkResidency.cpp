@@ -0,0 +1,134 @@
+#include "chunkResidency.hpp"
+#include "chunkCodec.hpp"
+#include <iostream>
+
+void ChunkResidency::demote(const glm::ivec3 &chunkPos, std::shared_ptr<ChunkData> chunk)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  auto old = entries.find(chunkPos);
+  if (old != entries.end())
+    remove(old);
+
+  recentlyUnloaded.push_front(chunkPos);
+  Entry entry;
+  entry.size = sizeof(Entry) + chunk->memoryUsage();
+  entry.chunk = std::move(chunk);
+  entry.recent = recentlyUnloaded.begin();
+  warmBytes += entry.size;
+  entries.emplace(chunkPos, std::move(entry));
+  counters.demotions++;
+  evict();
+}
+
+void ChunkResidency::compress(const glm::ivec3 &chunkPos, const std::shared_ptr<ChunkData> &chunk)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = entries.find(chunkPos);
+    if (it == entries.end() || it->second.chunk != chunk)
+      return;
+  }
+
+  // the chunk does not change anymore, it is only read here and by promote
+  std::vector<uint8_t> bytes;
+  encodeChunk(*chunk, bytes);
+  bytes.shrink_to_fit();
+
+  std::lock_guard<std::mutex> lock(mtx);
+  auto it = entries.find(chunkPos);
+  if (it == entries.end() || it->second.chunk != chunk)
+    return;
+  Entry &entry = it->second;
+  warmBytes -= entry.size;
+  entry.size = sizeof(Entry) + bytes.capacity();
+  entry.bytes = std::move(bytes);
+  entry.chunk.reset();
+  warmBytes += entry.size;
+}
+
+std::shared_ptr<ChunkData> ChunkResidency::promote(const glm::ivec3 &chunkPos)
+{
+  std::shared_ptr<ChunkData> uncompressed;
+  std::vector<uint8_t> bytes;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = entries.find(chunkPos);
+    if (it == entries.end())
+    {
+      counters.warmMisses++;
+      return nullptr;
+    }
+    counters.warmHits++;
+    uncompressed = std::move(it->second.chunk);
+    bytes = std::move(it->second.bytes);
+    remove(it);
+  }
+
+  // a chunk not compressed yet may still be read by compress, the caller gets a copy to change.
+  // Its mesh was dropped on unload, so it is remeshed whole like a decoded one
+  if (uncompressed)
+  {
+    auto chunk = std::make_shared<ChunkData>(*uncompressed);
+    chunk->dirtySections = ChunkData::allSections;
+    return chunk;
+  }
+
+  auto chunk = std::make_shared<ChunkData>(chunkPos);
+  if (!decodeChunk(bytes.data(), bytes.size(), *chunk))
+  {
+    std::cerr << "Discarding unreadable compressed chunk at " << chunkPos.x << ", " << chunkPos.z << std::endl;
+    return nullptr;
+  }
+  return chunk;
+}
+
+void ChunkResidency::setHotBytes(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  hotBytes = bytes;
+  evict();
+}
+
+void ChunkResidency::countHot(bool hit)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  (hit ? counters.hotHits : counters.hotMisses)++;
+}
+
+void ChunkResidency::countDisk(bool hit)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  (hit ? counters.diskHits : counters.diskMisses)++;
+}
+
+ResidencyStats ChunkResidency::stats() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  ResidencyStats stats = counters;
+  stats.hotBytes = hotBytes;
+  stats.warmBytes = warmBytes;
+  stats.warmChunks = entries.size();
+  return stats;
+}
+
+void ChunkResidency::remove(std::unordered_map<glm::ivec3, Entry, ChunkHasher>::iterator entry)
+{
+  warmBytes -= entry->second.size;
+  recentlyUnloaded.erase(entry->second.recent);
+  entries.erase(entry);
+}
+
+void ChunkResidency::evict()
+{
+  size_t limit = memoryBudget > hotBytes ? memoryBudget - hotBytes : 0;
+  if (warmBytes <= limit)
+    return;
+
+  // an eighth of the limit is freed at once, so a full tier does not evict on every demotion
+  size_t target = limit - limit / 8;
+  while (warmBytes > target && !recentlyUnloaded.empty())
+  {
+    remove(entries.find(recentlyUnloaded.back()));
+    counters.evictions++;
+  }
+}
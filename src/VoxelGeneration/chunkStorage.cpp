@@ -0,0 +1,663 @@
+#include "chunkStorage.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+
+namespace
+{
+  uint32_t readUint32(const uint8_t *bytes)
+  {
+    return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+  }
+
+  void writeUint32(uint8_t *bytes, uint32_t value)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+  }
+
+  int floorDivide(int numerator, int denominator)
+  {
+    return numerator >= 0 ? numerator / denominator : (numerator - denominator + 1) / denominator;
+  }
+}
+
+RegionFile::RegionFile(IOBackend &backend, const std::string &path) : backend(backend)
+{
+  std::fill(std::begin(locations), std::end(locations), 0);
+  usedSectors.assign(1, true);
+
+  file = backend.open(path);
+  if (file < 0)
+  {
+    std::cerr << "Failed to open region file " << path << std::endl;
+    return;
+  }
+
+  int64_t length = backend.fileSize(file);
+  uint8_t table[sectorSize] = {};
+  if (length < sectorSize)
+  {
+    if (!backend.writeNow(file, 0, table, sectorSize))
+      std::cerr << "Failed to write the table of region file " << path << std::endl;
+    return;
+  }
+
+  if (!backend.readNow(file, 0, table, sectorSize))
+  {
+    std::cerr << "Failed to read region file " << path << std::endl;
+    backend.close(file);
+    file = -1;
+    return;
+  }
+  for (int i = 0; i < regionSize * regionSize; i++)
+  {
+    uint32_t location = readUint32(table + i * 4);
+    uint32_t first = location >> 8;
+    uint32_t count = location & 0xFF;
+    // entries pointing into the table or past the end are from a damaged file, those chunks are regenerated
+    if (location == 0 || first == 0 || count == 0 || static_cast<int64_t>(first + count) * sectorSize > length)
+      continue;
+
+    locations[i] = location;
+    if (usedSectors.size() < first + count)
+      usedSectors.resize(first + count, false);
+    std::fill(usedSectors.begin() + first, usedSectors.begin() + first + count, true);
+  }
+}
+
+RegionFile::~RegionFile()
+{
+  if (file >= 0)
+    backend.close(file);
+}
+
+int RegionFile::allocate(int sectorCount)
+{
+  int runStart = 1;
+  int runLength = 0;
+  for (int sector = 1; sector < static_cast<int>(usedSectors.size()) && runLength < sectorCount; sector++)
+  {
+    if (usedSectors[sector])
+    {
+      runStart = sector + 1;
+      runLength = 0;
+    }
+    else
+    {
+      runLength++;
+    }
+  }
+
+  // a free run at the end of the file is extended
+  if (usedSectors.size() < static_cast<size_t>(runStart + sectorCount))
+    usedSectors.resize(runStart + sectorCount, false);
+  std::fill(usedSectors.begin() + runStart, usedSectors.begin() + runStart + sectorCount, true);
+  return runStart;
+}
+
+void RegionFile::release(uint32_t location)
+{
+  uint32_t first = location >> 8;
+  std::fill(usedSectors.begin() + first, usedSectors.begin() + first + (location & 0xFF), false);
+}
+
+void RegionFile::setLocation(int index, uint32_t location)
+{
+  if (locations[index] != 0)
+  {
+    if (reads == 0)
+      release(locations[index]);
+    else
+      replacedLocations.push_back(locations[index]);
+  }
+  locations[index] = location;
+}
+
+void RegionFile::beginRead()
+{
+  reads++;
+  operations++;
+}
+
+void RegionFile::endRead()
+{
+  reads--;
+  operations--;
+  if (reads != 0)
+    return;
+  for (uint32_t location : replacedLocations)
+  {
+    release(location);
+  }
+  replacedLocations.clear();
+}
+
+glm::ivec3 RegionFile::regionOf(const glm::ivec3 &chunkPos)
+{
+  return {floorDivide(chunkPos.x / ChunkData::chunkSize, regionSize), 0, floorDivide(chunkPos.z / ChunkData::chunkSize, regionSize)};
+}
+
+int RegionFile::chunkIndex(const glm::ivec3 &chunkPos)
+{
+  glm::ivec3 region = regionOf(chunkPos);
+  int localX = chunkPos.x / ChunkData::chunkSize - region.x * regionSize;
+  int localZ = chunkPos.z / ChunkData::chunkSize - region.z * regionSize;
+  return localX * regionSize + localZ;
+}
+
+ChunkStorage::ChunkStorage(std::string directory) : directory(std::move(directory))
+{
+  std::error_code error;
+  std::filesystem::create_directories(this->directory, error);
+  if (error)
+  {
+    std::cerr << "Failed to create save directory " << this->directory << ": " << error.message() << std::endl;
+  }
+
+  // journals left behind by a crash are replayed oldest first, the first compaction deletes them
+  std::vector<int> generations;
+  for (const auto &entry : std::filesystem::directory_iterator(this->directory, error))
+  {
+    std::string name = entry.path().filename().string();
+    if (name.size() > 14 && name.compare(0, 6, "edits.") == 0 && name.compare(name.size() - 8, 8, ".journal") == 0)
+      generations.push_back(std::atoi(name.c_str() + 6));
+  }
+  std::sort(generations.begin(), generations.end());
+  for (int generation : generations)
+  {
+    std::string path = journalPath(generation);
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> records((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    journal.replay(records.data(), records.size());
+    retiredJournals.push_back(path);
+    journalGeneration = generation + 1;
+  }
+  compactionRequested = journal.bytesSinceCompaction() != 0;
+  if (!compactionRequested)
+  {
+    for (const std::string &path : retiredJournals)
+    {
+      std::filesystem::remove(path, error);
+    }
+    retiredJournals.clear();
+  }
+
+  backend = createUringBackend(ringDepth);
+  if (!backend)
+    backend = createThreadPoolBackend(fallbackThreads);
+  latencies.reserve(latencySamples);
+  ioThread = std::thread([this]()
+                         { ioLoop(); });
+}
+
+ChunkStorage::~ChunkStorage()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  backend->wake();
+  ioThread.join();
+}
+
+void ChunkStorage::read(const glm::ivec3 &chunkPos, ReadCallback done)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto operation = std::make_unique<Operation>();
+    operation->kind = OperationKind::Read;
+    operation->chunkPos = chunkPos;
+    operation->requested = Clock::now();
+    operation->done = std::move(done);
+    requests.push_back(std::move(operation));
+    peakDepth = std::max(peakDepth, static_cast<int>(requests.size()) + operationsInFlight);
+  }
+  backend->wake();
+}
+
+ChunkPayload ChunkStorage::readAndWait(const glm::ivec3 &chunkPos)
+{
+  std::promise<ChunkPayload> result;
+  std::future<ChunkPayload> payload = result.get_future();
+  read(chunkPos, [&result](ChunkPayload &&payload)
+       { result.set_value(std::move(payload)); });
+  return payload.get();
+}
+
+std::shared_ptr<ChunkData> ChunkStorage::rebuild(const glm::ivec3 &chunkPos, const ChunkPayload &payload, const Generator &generate)
+{
+  std::vector<BlockEdit> storedEdits;
+  if (payload.size != 0 && !parseStored(payload.bytes.data() + payload.offset, payload.size, storedEdits))
+  {
+    std::cerr << "Discarding unreadable saved chunk at " << chunkPos.x << ", " << chunkPos.z << std::endl;
+    storedEdits.clear();
+  }
+
+  std::shared_ptr<ChunkData> chunk = generate();
+  EditJournal::apply(storedEdits, *chunk);
+  EditJournal::apply(payload.journalEdits, *chunk);
+  return chunk;
+}
+
+void ChunkStorage::recordEdit(const glm::ivec3 &chunkPos, const BlockEdit &edit)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    journal.record(chunkPos, edit);
+  }
+  backend->wake();
+}
+
+void ChunkStorage::compactJournal()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    compactionRequested = true;
+  }
+  backend->wake();
+
+  std::unique_lock<std::mutex> lock(mtx);
+  idle.wait(lock, [this]()
+            { return requests.empty() && operationsInFlight == 0 && !compactionRequested && journal.unwritten.empty(); });
+}
+
+ChunkIOStats ChunkStorage::stats() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  ChunkIOStats stats = {};
+  stats.backend = backend->name();
+  stats.queued = static_cast<int>(requests.size());
+  stats.inFlight = operationsInFlight;
+  stats.peakDepth = peakDepth;
+  stats.reads = reads;
+  stats.writes = writes;
+  if (latencies.empty())
+    return stats;
+
+  std::vector<float> sorted = latencies;
+  std::sort(sorted.begin(), sorted.end());
+  auto percentile = [&sorted](float fraction)
+  {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+  };
+  stats.latencyP50Ms = percentile(0.5f);
+  stats.latencyP90Ms = percentile(0.9f);
+  stats.latencyP99Ms = percentile(0.99f);
+  stats.latencyMaxMs = sorted.back();
+  return stats;
+}
+
+std::string ChunkStorage::journalPath(int generation) const
+{
+  return directory + "/edits." + std::to_string(generation) + ".journal";
+}
+
+void ChunkStorage::openJournal()
+{
+  std::string path = journalPath(journalGeneration);
+  journalFile = backend->open(path);
+  journalEnd = journalFile >= 0 ? static_cast<uint64_t>(std::max<int64_t>(backend->fileSize(journalFile), 0)) : 0;
+  if (journalFile < 0)
+    std::cerr << "Failed to open edit journal " << path << ", edits are only kept until the next compaction" << std::endl;
+}
+
+void ChunkStorage::ioLoop()
+{
+  openJournal();
+
+  std::vector<std::unique_ptr<Operation>> taken;
+  std::vector<uint8_t> records;
+  std::vector<glm::ivec3> compacting;
+  std::vector<IORequest> batch;
+  while (true)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (stopping && requests.empty() && operationsInFlight == 0 && journal.unwritten.empty())
+        break;
+      taken.swap(requests);
+      operationsInFlight += static_cast<int>(taken.size());
+      records.swap(journal.unwritten);
+      if (!records.empty())
+        operationsInFlight++;
+
+      // one compaction at a time, started once the journal grew enough or when asked for
+      if (!compactionRunning && (compactionRequested || journal.bytesSinceCompaction() >= compactionBytes))
+      {
+        compactionRequested = false;
+        if (journal.beginCompaction())
+        {
+          for (const auto &[chunkPos, edits] : journal.compactingEdits())
+          {
+            compacting.push_back(chunkPos);
+          }
+          operationsInFlight += static_cast<int>(compacting.size());
+        }
+      }
+      if (operationsInFlight == 0 && !compactionRequested)
+        idle.notify_all();
+    }
+
+    // everything requested since the last pass goes to the backend as one batch. The records taken
+    // along with a compaction still go to the journal it retires, newer ones to a new journal
+    if (!records.empty())
+      append(std::move(records), batch);
+    records.clear();
+    if (!compacting.empty())
+    {
+      retiredJournalFile = journalFile;
+      retiredJournals.push_back(journalPath(journalGeneration));
+      journalGeneration++;
+      openJournal();
+      startCompaction(compacting, batch);
+      compacting.clear();
+    }
+    for (std::unique_ptr<Operation> &operation : taken)
+    {
+      startRead(operation.release(), batch);
+    }
+    taken.clear();
+    backend->submit(batch);
+
+    bool moreRequested;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      moreRequested = !requests.empty() || !journal.unwritten.empty();
+    }
+    backend->complete(!moreRequested);
+  }
+
+  // a journal nothing was appended to is not left behind
+  if (journalFile >= 0)
+  {
+    backend->close(journalFile);
+    std::error_code error;
+    if (journalEnd == 0)
+      std::filesystem::remove(journalPath(journalGeneration), error);
+  }
+}
+
+void ChunkStorage::append(std::vector<uint8_t> &&records, std::vector<IORequest> &batch)
+{
+  Operation *operation = new Operation();
+  operation->kind = OperationKind::Append;
+  operation->requested = Clock::now();
+  operation->buffer = std::move(records);
+  if (journalFile < 0)
+  {
+    finish(operation);
+    return;
+  }
+
+  appendsInFlight++;
+  uint64_t offset = journalEnd;
+  journalEnd += operation->buffer.size();
+  batch.push_back({journalFile, true, offset, operation->buffer.data(), static_cast<uint32_t>(operation->buffer.size()), [this, operation](int64_t result)
+                   {
+                     if (result != static_cast<int64_t>(operation->buffer.size()))
+                       std::cerr << "Failed to append to the edit journal, edits are only kept until the next compaction" << std::endl;
+                     appendsInFlight--;
+                     finishCompaction();
+                     finish(operation); }});
+}
+
+void ChunkStorage::startCompaction(const std::vector<glm::ivec3> &chunks, std::vector<IORequest> &batch)
+{
+  compactionRunning = true;
+  compactionsLeft = static_cast<int>(chunks.size());
+  for (const glm::ivec3 &chunkPos : chunks)
+  {
+    Operation *operation = new Operation();
+    operation->kind = OperationKind::Compact;
+    operation->chunkPos = chunkPos;
+    operation->requested = Clock::now();
+    startRead(operation, batch);
+  }
+}
+
+void ChunkStorage::startRead(Operation *operation, std::vector<IORequest> &batch)
+{
+  if (operation->kind == OperationKind::Read)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    operation->journalEdits = journal.editsOf(operation->chunkPos);
+  }
+
+  RegionFile *region = openRegion(operation->chunkPos);
+  uint32_t location = region->isOpen() ? region->location(RegionFile::chunkIndex(operation->chunkPos)) : 0;
+  if (location == 0)
+  {
+    readFinished(operation, 0);
+    return;
+  }
+
+  operation->region = region;
+  region->beginRead();
+  operation->buffer.resize(static_cast<size_t>(location & 0xFF) * RegionFile::sectorSize);
+  batch.push_back({region->handle(), false, static_cast<uint64_t>(location >> 8) * RegionFile::sectorSize, operation->buffer.data(), static_cast<uint32_t>(operation->buffer.size()), [this, operation](int64_t result)
+                   { readFinished(operation, result); }});
+}
+
+void ChunkStorage::readFinished(Operation *operation, int64_t result)
+{
+  // the payload keeps the buffer it was read into
+  ChunkPayload payload;
+  if (operation->region)
+  {
+    operation->region->endRead();
+    operation->region = nullptr;
+    std::vector<uint8_t> &buffer = operation->buffer;
+    uint32_t length = result == static_cast<int64_t>(buffer.size()) ? readUint32(buffer.data()) : 0;
+    if (length == 0 || length > buffer.size() - 4)
+    {
+      std::cerr << "Discarding unreadable saved chunk at " << operation->chunkPos.x << ", " << operation->chunkPos.z << std::endl;
+    }
+    else
+    {
+      payload.offset = 4;
+      payload.size = length;
+      payload.bytes = std::move(buffer);
+    }
+  }
+
+  if (operation->kind == OperationKind::Compact)
+  {
+    writeSnapshot(operation, payload);
+    return;
+  }
+  payload.journalEdits = std::move(operation->journalEdits);
+  operation->done(std::move(payload));
+  finish(operation);
+}
+
+void ChunkStorage::writeSnapshot(Operation *operation, const ChunkPayload &stored)
+{
+  const glm::ivec3 &chunkPos = operation->chunkPos;
+  std::vector<BlockEdit> storedEdits;
+  if (stored.size != 0 && !parseStored(stored.bytes.data() + stored.offset, stored.size, storedEdits))
+  {
+    std::cerr << "Discarding unreadable saved chunk at " << chunkPos.x << ", " << chunkPos.z << std::endl;
+    storedEdits.clear();
+  }
+
+  std::vector<BlockEdit> compacted;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = journal.compactingEdits().find(chunkPos);
+    if (it != journal.compactingEdits().end())
+      compacted = it->second;
+  }
+  std::vector<BlockEdit> edits = EditJournal::merge(storedEdits, compacted);
+
+  // the length goes in front and the padding behind here, the buffer is written as it is. A chunk
+  // back to its generated terrain is only removed from the table
+  std::vector<uint8_t> buffer;
+  if (!edits.empty())
+  {
+    buffer.resize(5);
+    buffer[4] = formatVersion;
+    EditJournal::encodeSnapshot(edits, buffer);
+    writeUint32(buffer.data(), static_cast<uint32_t>(buffer.size() - 4));
+  }
+  size_t sectorCount = (buffer.size() + RegionFile::sectorSize - 1) / RegionFile::sectorSize;
+  if (sectorCount > RegionFile::maxSectorsPerChunk)
+  {
+    std::cerr << "Edits of " << buffer.size() << " bytes do not fit a region file" << std::endl;
+    snapshotWritten(operation, false);
+    return;
+  }
+  buffer.resize(sectorCount * RegionFile::sectorSize, 0);
+  operation->buffer = std::move(buffer);
+
+  RegionFile *region = openRegion(chunkPos);
+  int index = RegionFile::chunkIndex(chunkPos);
+  if (!region->isOpen() || (sectorCount == 0 && region->location(index) == 0))
+  {
+    snapshotWritten(operation, region->isOpen());
+    return;
+  }
+
+  operation->region = region;
+  region->operations++;
+  if (sectorCount == 0)
+  {
+    operation->location = 0;
+    writeTableEntry(operation);
+    return;
+  }
+
+  int first = region->allocate(static_cast<int>(sectorCount));
+  operation->location = static_cast<uint32_t>(first) << 8 | static_cast<uint32_t>(sectorCount);
+  std::vector<IORequest> sectors;
+  sectors.push_back({region->handle(), true, static_cast<uint64_t>(first) * RegionFile::sectorSize, operation->buffer.data(), static_cast<uint32_t>(operation->buffer.size()), [this, operation](int64_t result)
+                     {
+                       if (result == static_cast<int64_t>(operation->buffer.size()))
+                       {
+                         writeTableEntry(operation);
+                         return;
+                       }
+                       operation->region->release(operation->location);
+                       snapshotWritten(operation, false); }});
+  backend->submit(sectors);
+}
+
+void ChunkStorage::writeTableEntry(Operation *operation)
+{
+  // the new copy went to free sectors and the table entry goes last, so a failed write keeps the old copy
+  int index = RegionFile::chunkIndex(operation->chunkPos);
+  writeUint32(operation->tableEntry, operation->location);
+  std::vector<IORequest> entry;
+  entry.push_back({operation->region->handle(), true, static_cast<uint64_t>(index) * 4, operation->tableEntry, sizeof(operation->tableEntry), [this, operation, index](int64_t result)
+                   {
+                     bool written = result == sizeof(operation->tableEntry);
+                     if (written)
+                       operation->region->setLocation(index, operation->location);
+                     else if (operation->location != 0)
+                       operation->region->release(operation->location);
+                     snapshotWritten(operation, written); }});
+  backend->submit(entry);
+}
+
+void ChunkStorage::snapshotWritten(Operation *operation, bool written)
+{
+  if (operation->region)
+    operation->region->operations--;
+  if (!written)
+  {
+    std::cerr << "Failed to write the edits of chunk at " << operation->chunkPos.x << ", " << operation->chunkPos.z << " to its region file" << std::endl;
+    compactionFailed = true;
+  }
+  compactionsLeft--;
+  finishCompaction();
+  finish(operation);
+}
+
+void ChunkStorage::finishCompaction()
+{
+  // the retired journal is closed once its last append completed
+  if (!compactionRunning || compactionsLeft != 0 || appendsInFlight != 0)
+    return;
+
+  if (retiredJournalFile >= 0)
+    backend->close(retiredJournalFile);
+  retiredJournalFile = -1;
+  // a failed compaction keeps the journals, their edits are compacted again later
+  if (!compactionFailed)
+  {
+    std::error_code error;
+    for (const std::string &path : retiredJournals)
+    {
+      std::filesystem::remove(path, error);
+    }
+    retiredJournals.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    journal.endCompaction(!compactionFailed);
+  }
+  compactionRunning = false;
+  compactionFailed = false;
+}
+
+void ChunkStorage::finish(Operation *operation)
+{
+  float latencyMs = std::chrono::duration<float, std::milli>(Clock::now() - operation->requested).count();
+  bool read = operation->kind == OperationKind::Read;
+  delete operation;
+
+  std::lock_guard<std::mutex> lock(mtx);
+  operationsInFlight--;
+  (read ? reads : writes)++;
+  if (latencies.size() < latencySamples)
+  {
+    latencies.push_back(latencyMs);
+  }
+  else
+  {
+    latencies[nextLatency] = latencyMs;
+    nextLatency = (nextLatency + 1) % latencySamples;
+  }
+
+  if (requests.empty() && operationsInFlight == 0 && !compactionRequested && journal.unwritten.empty())
+    idle.notify_all();
+}
+
+bool ChunkStorage::parseStored(const uint8_t *data, size_t size, std::vector<BlockEdit> &edits)
+{
+  if (size < 1 || data[0] != formatVersion)
+    return false;
+  return EditJournal::decodeSnapshot(data + 1, size - 1, edits);
+}
+
+RegionFile *ChunkStorage::openRegion(const glm::ivec3 &chunkPos)
+{
+  glm::ivec3 regionPos = RegionFile::regionOf(chunkPos);
+  auto it = regions.find(regionPos);
+  if (it != regions.end())
+    return it->second.get();
+
+  // only regions without requests in flight are closed
+  if (regions.size() >= maxOpenRegions)
+  {
+    for (auto region = regions.begin(); region != regions.end(); ++region)
+    {
+      if (region->second->operations == 0)
+      {
+        regions.erase(region);
+        break;
+      }
+    }
+  }
+
+  std::string path = directory + "/r." + std::to_string(regionPos.x) + "." + std::to_string(regionPos.z) + ".region";
+  auto region = std::make_unique<RegionFile>(*backend, path);
+  RegionFile *opened = region.get();
+  regions.emplace(regionPos, std::move(region));
+  return opened;
+}
@@ -0,0 +1,150 @@
+#include "editJournal.hpp"
+#include <algorithm>
+
+namespace
+{
+  void writeInt32(std::vector<uint8_t> &out, uint32_t value)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+  }
+
+  uint32_t readInt32(const uint8_t *bytes)
+  {
+    return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+  }
+
+  // gameplay only places and removes real blocks, any other byte comes from a damaged file
+  bool isEditedType(uint8_t type)
+  {
+    return type >= static_cast<uint8_t>(BlockType::Air) && type <= static_cast<uint8_t>(BlockType::Tree_Leafes_Solid);
+  }
+}
+
+void EditJournal::apply(const std::vector<BlockEdit> &edits, ChunkData &chunk)
+{
+  for (const BlockEdit &edit : edits)
+  {
+    chunk.setBlock(edit.index & 0xF, edit.index >> 8, (edit.index >> 4) & 0xF, edit.after);
+  }
+}
+
+std::vector<BlockEdit> EditJournal::merge(const std::vector<BlockEdit> &older, const std::vector<BlockEdit> &newer)
+{
+  std::vector<BlockEdit> all = older;
+  all.insert(all.end(), newer.begin(), newer.end());
+  std::stable_sort(all.begin(), all.end(), [](const BlockEdit &a, const BlockEdit &b)
+                   { return a.index < b.index; });
+
+  std::vector<BlockEdit> merged;
+  for (size_t first = 0; first < all.size();)
+  {
+    size_t last = first;
+    while (last + 1 < all.size() && all[last + 1].index == all[first].index)
+      last++;
+
+    if (all[first].before != all[last].after)
+      merged.push_back({all[first].index, all[first].before, all[last].after});
+    first = last + 1;
+  }
+  return merged;
+}
+
+void EditJournal::encodeSnapshot(const std::vector<BlockEdit> &edits, std::vector<uint8_t> &out)
+{
+  writeInt32(out, static_cast<uint32_t>(edits.size()));
+  for (const BlockEdit &edit : edits)
+  {
+    out.push_back(static_cast<uint8_t>(edit.index));
+    out.push_back(static_cast<uint8_t>(edit.index >> 8));
+    out.push_back(static_cast<uint8_t>(edit.before));
+    out.push_back(static_cast<uint8_t>(edit.after));
+  }
+}
+
+bool EditJournal::decodeSnapshot(const uint8_t *data, size_t size, std::vector<BlockEdit> &edits)
+{
+  if (size < 4)
+    return false;
+  uint32_t count = readInt32(data);
+  if (size != 4 + static_cast<size_t>(count) * 4)
+    return false;
+
+  edits.clear();
+  edits.reserve(count);
+  for (const uint8_t *edit = data + 4; edit != data + size; edit += 4)
+  {
+    if (!isEditedType(edit[2]) || !isEditedType(edit[3]))
+    {
+      edits.clear();
+      return false;
+    }
+    edits.push_back({static_cast<uint16_t>(edit[0] | edit[1] << 8), static_cast<BlockType>(edit[2]), static_cast<BlockType>(edit[3])});
+  }
+  return true;
+}
+
+void EditJournal::record(const glm::ivec3 &chunkPos, const BlockEdit &edit)
+{
+  edits[chunkPos].push_back(edit);
+  writeInt32(unwritten, static_cast<uint32_t>(chunkPos.x / ChunkData::chunkSize));
+  writeInt32(unwritten, static_cast<uint32_t>(chunkPos.z / ChunkData::chunkSize));
+  unwritten.push_back(static_cast<uint8_t>(edit.index));
+  unwritten.push_back(static_cast<uint8_t>(edit.index >> 8));
+  unwritten.push_back(static_cast<uint8_t>(edit.before));
+  unwritten.push_back(static_cast<uint8_t>(edit.after));
+  journalBytes += recordSize;
+}
+
+void EditJournal::replay(const uint8_t *data, size_t size)
+{
+  for (size_t offset = 0; offset + recordSize <= size; offset += recordSize)
+  {
+    // only changes are recorded, a record changing nothing is a hole left by a failed append,
+    // and one with an unknown block type is damaged
+    const uint8_t *record = data + offset;
+    if (record[10] == record[11] || !isEditedType(record[10]) || !isEditedType(record[11]))
+      continue;
+    glm::ivec3 chunkPos(static_cast<int32_t>(readInt32(record)) * ChunkData::chunkSize, 0, static_cast<int32_t>(readInt32(record + 4)) * ChunkData::chunkSize);
+    edits[chunkPos].push_back({static_cast<uint16_t>(record[8] | record[9] << 8), static_cast<BlockType>(record[10]), static_cast<BlockType>(record[11])});
+    journalBytes += recordSize;
+  }
+}
+
+std::vector<BlockEdit> EditJournal::editsOf(const glm::ivec3 &chunkPos) const
+{
+  std::vector<BlockEdit> result;
+  auto older = compacting.find(chunkPos);
+  if (older != compacting.end())
+    result = older->second;
+  auto newer = edits.find(chunkPos);
+  if (newer != edits.end())
+    result.insert(result.end(), newer->second.begin(), newer->second.end());
+  return result;
+}
+
+bool EditJournal::beginCompaction()
+{
+  if (edits.empty())
+    return false;
+  compacting = std::move(edits);
+  edits.clear();
+  journalBytes = 0;
+  return true;
+}
+
+void EditJournal::endCompaction(bool written)
+{
+  if (!written)
+  {
+    for (auto &[chunkPos, newer] : edits)
+    {
+      std::vector<BlockEdit> &older = compacting[chunkPos];
+      older.insert(older.end(), newer.begin(), newer.end());
+    }
+    edits = std::move(compacting);
+  }
+  compacting.clear();
+}
@@ -1,136 +1,462 @@
 #include "meshGenerator.hpp"
 #include "world.hpp"
+#include <algorithm>
+#include <cmath>
 
-bool MeshGenerator::generateMesh(World *world, BlockDataSO &textureData, const std::shared_ptr<ChunkData> &chunk)
+bool MeshGenerator::generateMesh(World *world, BlockDataSO &textureData, const std::shared_ptr<ChunkData> &chunk, uint16_t sectionMask)
 {
-  vertices.clear();
-  indices.clear();
+  world->buildNeighborhood(chunk->worldPosition, neighborhood);
+  return generateMesh(neighborhood, textureData, sectionMask);
+}
+
+bool MeshGenerator::generateMesh(const ChunkNeighborhood &sourceBlocks, BlockDataSO &textureData, uint16_t sectionMask)
+{
+  sectionMeshes.clear();
+  sectionMeshes.reserve(__builtin_popcount(sectionMask));
+
+  bool coarse = sourceBlocks.lodLevel > 0;
+  if (coarse)
+    prepareLodNeighborhood(sourceBlocks, lodNeighborhood);
+  const ChunkNeighborhood &blocks = coarse ? lodNeighborhood : sourceBlocks;
+  bakeAmbientOcclusion = ambientOcclusion && blocks.lodLevel == 0;
+
+  if (meshingMode == MeshingMode::Binary)
+  {
+    buildFaceColumns(blocks, sectionMask);
+  }
+
+  for (int section = 0; section < ChunkData::sectionCount; ++section)
+  {
+    if (!(sectionMask & (1u << section)))
+      continue;
+
+    // empty sections still get an entry so their old mesh is dropped
+    sectionMeshes.push_back(bufferPool ? bufferPool->acquire(section) : SectionMeshData(section));
+    if (blocks.sectionEmpty[section])
+      continue;
+
+    if (meshingMode == MeshingMode::Greedy)
+    {
+      for (int face = 0; face < 6; ++face)
+      {
+        greedyMeshDirection(blocks, textureData, face, section);
+      }
+    }
+    else if (meshingMode == MeshingMode::Binary)
+    {
+      for (int face = 0; face < 6; ++face)
+      {
+        binaryMeshDirection(blocks, textureData, face, section);
+      }
+    }
+    else
+    {
+      naiveMesh(blocks, textureData, section);
+    }
+  }
+
+  return true;
+}
 
-  uint32_t indexCount = 0;
+void MeshGenerator::naiveMesh(const ChunkNeighborhood &blocks, BlockDataSO &textureData, int section)
+{
+  int neighborOffsets[6];
+  for (int face = 0; face < 6; ++face)
+  {
+    neighborOffsets[face] = directions[face].x * ChunkNeighborhood::strideX + directions[face].y * ChunkNeighborhood::strideY + directions[face].z * ChunkNeighborhood::strideZ;
+  }
 
+  int sectionBottom = section * ChunkData::sectionHeight;
   for (int x = 0; x < ChunkData::chunkSize; ++x)
-    for (int y = 0; y < ChunkData::chunkHeight; ++y)
+    for (int y = sectionBottom; y < sectionBottom + ChunkData::sectionHeight; ++y)
       for (int z = 0; z < ChunkData::chunkSize; ++z)
       {
-        BlockType block;
-        {
-          std::lock_guard<std::mutex> lock(world->chunkMutex);
-          block = chunk->getBlock(x, y, z);
-        }
+        int index = blocks.toIndex(x, y, z);
+        BlockType block = blocks.blocks[index];
         if (block == BlockType::Nothing || block == BlockType::Air)
           continue;
 
         for (int face = 0; face < 6; ++face)
         {
-          glm::ivec3 neighborPos = glm::ivec3(x, y, z) + directions[face];
-          BlockType neighborBlock;
-          if (neighborPos.x < 0 || neighborPos.x >= ChunkData::chunkSize ||
-              neighborPos.y < 0 || neighborPos.y >= ChunkData::chunkHeight ||
-              neighborPos.z < 0 || neighborPos.z >= ChunkData::chunkSize)
+          if (isFaceVisible(block, blocks.blocks[index + neighborOffsets[face]]))
           {
-            glm::ivec3 worldPosition = chunk->worldPosition + neighborPos;
+            addQuad(textureData, block, face, glm::ivec3(x, y, z), glm::ivec3(1), faceAmbientOcclusion(blocks, glm::ivec3(x, y, z), face));
+          }
+        }
+      }
+}
+
+void MeshGenerator::greedyMeshDirection(const ChunkNeighborhood &blocks, BlockDataSO &textureData, int face, int section)
+{
+  int axis = face / 2;
+  int uAxis = faceUAxis[axis];
+  int vAxis = faceVAxis[axis];
+
+  glm::ivec3 low(0, section * ChunkData::sectionHeight, 0);
+  glm::ivec3 high(ChunkData::chunkSize, (section + 1) * ChunkData::sectionHeight, ChunkData::chunkSize);
+  int uSize = high[uAxis] - low[uAxis];
+  int vSize = high[vAxis] - low[vAxis];
+  int neighborOffset = directions[face].x * ChunkNeighborhood::strideX + directions[face].y * ChunkNeighborhood::strideY + directions[face].z * ChunkNeighborhood::strideZ;
+
+  faceMask.resize(uSize * vSize);
+
+  for (int slice = low[axis]; slice < high[axis]; ++slice)
+  {
+    bool anyFace = false;
+    glm::ivec3 pos;
+    pos[axis] = slice;
+    for (int v = 0; v < vSize; ++v)
+    {
+      pos[vAxis] = low[vAxis] + v;
+      for (int u = 0; u < uSize; ++u)
+      {
+        pos[uAxis] = low[uAxis] + u;
+        int index = blocks.toIndex(pos.x, pos.y, pos.z);
+        BlockType block = blocks.blocks[index];
+        bool visible = isFaceVisible(block, blocks.blocks[index + neighborOffset]);
+        faceMask[u + v * uSize] = visible ? uint16_t(block) | uint16_t(faceAmbientOcclusion(blocks, pos, face) << 8) : 0;
+        anyFace |= visible;
+      }
+    }
+
+    if (!anyFace)
+      continue;
+
+    for (int v = 0; v < vSize; ++v)
+    {
+      for (int u = 0; u < uSize;)
+      {
+        uint16_t key = faceMask[u + v * uSize];
+        if (key == 0)
+        {
+          u++;
+          continue;
+        }
+
+        int width = 1;
+        while (u + width < uSize && faceMask[u + width + v * uSize] == key)
+          width++;
+
+        int height = 1;
+        while (v + height < vSize)
+        {
+          uint16_t *row = &faceMask[u + (v + height) * uSize];
+          if (std::any_of(row, row + width, [key](uint16_t other)
+                          { return other != key; }))
+            break;
+          height++;
+        }
+
+        for (int dv = 0; dv < height; ++dv)
+        {
+          uint16_t *row = &faceMask[u + (v + dv) * uSize];
+          std::fill(row, row + width, uint16_t(0));
+        }
+
+        glm::ivec3 origin;
+        origin[axis] = slice;
+        origin[uAxis] = low[uAxis] + u;
+        origin[vAxis] = low[vAxis] + v;
+
+        glm::ivec3 size(1);
+        size[uAxis] = width;
+        size[vAxis] = height;
 
-            neighborBlock = world->getBlock(worldPosition.x, worldPosition.y, worldPosition.z); // has mutex lock inside btw
+        addQuad(textureData, BlockType(key & 0xFF), face, origin, size, key >> 8);
+        u += width;
+      }
+    }
+  }
+}
+
+void MeshGenerator::buildFaceColumns(const ChunkNeighborhood &blocks, uint16_t sectionMask)
+{
+  // the sections above and below are needed for the vertical faces of the meshed ones
+  uint16_t occupiedMask = sectionMask | uint16_t(sectionMask << 1) | uint16_t(sectionMask >> 1);
+
+  const int columnCount = ChunkNeighborhood::sizeX * ChunkNeighborhood::sizeZ;
+  opaqueColumns.assign(columnCount * columnBands, 0);
+  waterColumns.assign(columnCount * columnBands, 0);
+
+  // empty sections keep zero bits for the border columns too, they only border faces of the same empty section
+  for (int section = 0; section < ChunkData::sectionCount; ++section)
+  {
+    if (blocks.sectionEmpty[section] || !(occupiedMask & (1u << section)))
+      continue;
+
+    int sectionBottom = section * ChunkData::sectionHeight;
+    for (int y = sectionBottom; y < sectionBottom + ChunkData::sectionHeight; ++y)
+    {
+      int band = y >> 6;
+      uint64_t bit = uint64_t(1) << (y & 63);
+      const BlockType *layer = &blocks.blocks[blocks.toIndex(-1, y, -1)];
+      for (int column = 0; column < columnCount; ++column)
+      {
+        BlockType block = layer[column];
+        if (block == BlockType::Water)
+          waterColumns[column * columnBands + band] |= bit;
+        else if (block != BlockType::Air && block != BlockType::Nothing)
+          opaqueColumns[column * columnBands + band] |= bit;
+      }
+    }
+  }
+
+  // a face is visible when an opaque block borders a non opaque one, or water borders air / Nothing
+  const int chunkColumns = ChunkData::chunkSize * ChunkData::chunkSize;
+  faceColumns.assign(6 * chunkColumns * columnBands, 0);
+  for (int z = 0; z < ChunkData::chunkSize; ++z)
+    for (int x = 0; x < ChunkData::chunkSize; ++x)
+    {
+      int column = (x + 1) + (z + 1) * ChunkNeighborhood::sizeX;
+      for (int band = 0; band < columnBands; ++band)
+      {
+        uint64_t opaque = opaqueColumns[column * columnBands + band];
+        uint64_t water = waterColumns[column * columnBands + band];
+        if ((opaque | water) == 0)
+          continue;
+
+        for (int face = 0; face < 6; ++face)
+        {
+          uint64_t neighborOpaque;
+          uint64_t neighborWater;
+          if (face == 2)
+          {
+            bool hasAbove = band + 1 < columnBands;
+            neighborOpaque = (opaque >> 1) | (hasAbove ? opaqueColumns[column * columnBands + band + 1] << 63 : 0);
+            neighborWater = (water >> 1) | (hasAbove ? waterColumns[column * columnBands + band + 1] << 63 : 0);
+          }
+          else if (face == 3)
+          {
+            bool hasBelow = band > 0;
+            neighborOpaque = (opaque << 1) | (hasBelow ? opaqueColumns[column * columnBands + band - 1] >> 63 : 0);
+            neighborWater = (water << 1) | (hasBelow ? waterColumns[column * columnBands + band - 1] >> 63 : 0);
           }
           else
           {
-            std::lock_guard<std::mutex> lock(world->chunkMutex);
-            neighborBlock = chunk->getBlock(neighborPos.x, neighborPos.y, neighborPos.z);
+            int neighborColumn = column + directions[face].x + directions[face].z * ChunkNeighborhood::sizeX;
+            neighborOpaque = opaqueColumns[neighborColumn * columnBands + band];
+            neighborWater = waterColumns[neighborColumn * columnBands + band];
           }
 
-          if (neighborBlock == BlockType::Nothing || neighborBlock == BlockType::Air || (block != BlockType::Water && neighborBlock == BlockType::Water))
-          {
-            for (int vert = 0; vert < 4; ++vert)
-            {
-              glm::vec3 vertexPos = glm::vec3(x, y, z) + faceVertices[face][vert] + 0.5f;
-              Vertex vertex;
-              vertex.color = glm::vec3(0);
-              vertex.normal = directions[face];
-              vertex.pos = vertexPos;
-              vertex.tileSize = glm::vec2(textureData.textureSizeX, textureData.textureSizeY); // - glm::vec2(0.03);
-              vertex.repeatCount = glm::u8vec2(1, 1);
-              glm::vec2 uv = glm::vec2(1, 1);
-
-              if (face == 2)
-              {
-                vertex.tileStart = glm::vec2(textureData.textureDataList.at(block).up.x * textureData.textureSizeX, textureData.textureDataList.at(block).up.y * textureData.textureSizeY);
-              }
-              else if (face == 3)
-              {
-                vertex.tileStart = glm::vec2(textureData.textureDataList.at(block).down.x * textureData.textureSizeX, textureData.textureDataList.at(block).down.y * textureData.textureSizeY);
-              }
-              else
-              {
-                vertex.tileStart = glm::vec2(textureData.textureDataList.at(block).side.x * textureData.textureSizeX, textureData.textureDataList.at(block).side.y * textureData.textureSizeY);
-              }
-              // vertex.tileStart += glm::vec2(0.008);
+          uint64_t visible = (opaque & ~neighborOpaque) | (water & ~(neighborOpaque | neighborWater));
+          faceColumns[((face * chunkColumns) + x + z * ChunkData::chunkSize) * columnBands + band] = visible;
+        }
+      }
+    }
+}
 
-              if (face == 2 || face == 3 || face == 0 || face == 1)
-              {
-                if (vert == 1)
-                {
-                  uv.y -= vertex.repeatCount.y;
-                }
-                if (vert == 2)
-                {
-                  uv.y -= vertex.repeatCount.y;
-                  uv.x += vertex.repeatCount.x;
-                }
-                if (vert == 3)
-                {
-                  uv.x += vertex.repeatCount.x;
-                }
-              }
-              else if (face == 4 || face == 5)
-              {
-                if (vert == 1)
-                {
-                  uv.x += vertex.repeatCount.x;
-                }
-                if (vert == 2)
-                {
-                  uv.y -= vertex.repeatCount.y;
-                  uv.x += vertex.repeatCount.x;
-                }
-                if (vert == 3)
-                {
-                  uv.y -= vertex.repeatCount.y;
-                }
-              }
-              vertex.texPos = uv;
+void MeshGenerator::binaryMeshDirection(const ChunkNeighborhood &blocks, BlockDataSO &textureData, int face, int section)
+{
+  int axis = face / 2;
+  int uAxis = faceUAxis[axis];
+  int vAxis = faceVAxis[axis];
+
+  // plane positions are section local, every axis of a section is 16 blocks long
+  const int size = ChunkData::sectionHeight;
+  const glm::ivec3 sectionOrigin(0, section * ChunkData::sectionHeight, 0);
+  int band = section * ChunkData::sectionHeight / 64;
+  int bandShift = section * ChunkData::sectionHeight % 64;
 
-              vertices.emplace_back(vertex);
-            }
+  // transpose the visible bits of every column into u rows
+  std::fill(std::begin(facePlane), std::end(facePlane), uint16_t(0));
+  const int chunkColumns = ChunkData::chunkSize * ChunkData::chunkSize;
+  bool anyFace = false;
+  for (int z = 0; z < ChunkData::chunkSize; ++z)
+    for (int x = 0; x < ChunkData::chunkSize; ++x)
+    {
+      uint32_t bits = uint32_t(faceColumns[((face * chunkColumns) + x + z * ChunkData::chunkSize) * columnBands + band] >> bandShift) & 0xFFFF;
+      while (bits)
+      {
+        glm::ivec3 pos(x, __builtin_ctz(bits), z);
+        bits &= bits - 1;
+        int row = pos[axis] * size + pos[vAxis];
+        facePlane[row] |= uint16_t(1u << pos[uAxis]);
+        faceOcclusion[row * size + pos[uAxis]] = uint8_t(faceAmbientOcclusion(blocks, pos + sectionOrigin, face));
+        anyFace = true;
+      }
+    }
 
-            indices.push_back(indexCount + 0);
-            indices.push_back(indexCount + 1);
-            indices.push_back(indexCount + 2);
+  if (!anyFace)
+    return;
 
-            indices.push_back(indexCount + 2);
-            indices.push_back(indexCount + 3);
-            indices.push_back(indexCount + 0);
+  auto blockAt = [&](const glm::ivec3 &pos)
+  {
+    return blocks.getBlock(pos.x, pos.y + sectionOrigin.y, pos.z);
+  };
+
+  for (int slice = 0; slice < size; ++slice)
+  {
+    uint16_t *rows = &facePlane[slice * size];
+    const uint8_t *occlusion = &faceOcclusion[slice * size * size];
+    glm::ivec3 pos;
+    pos[axis] = slice;
+    for (int v = 0; v < size; ++v)
+    {
+      uint32_t row = rows[v];
+      while (row)
+      {
+        int u = __builtin_ctz(row);
+        pos[uAxis] = u;
+        pos[vAxis] = v;
+        BlockType block = blockAt(pos);
+        int ambientOcclusion = occlusion[v * size + u];
 
-            indexCount += 4;
+        // run of set bits starting at u, cut where the block type or the corner occlusion changes
+        int run = __builtin_ctz(~(row >> u));
+        int width = 1;
+        while (width < run)
+        {
+          pos[uAxis] = u + width;
+          if (blockAt(pos) != block || occlusion[v * size + u + width] != ambientOcclusion)
+            break;
+          width++;
+        }
+
+        uint32_t mask = ((1u << width) - 1) << u;
+        int height = 1;
+        while (v + height < size && (rows[v + height] & mask) == mask)
+        {
+          pos[vAxis] = v + height;
+          bool sameBlock = true;
+          for (int du = 0; du < width && sameBlock; ++du)
+          {
+            pos[uAxis] = u + du;
+            sameBlock = blockAt(pos) == block && occlusion[(v + height) * size + u + du] == ambientOcclusion;
           }
+          if (!sameBlock)
+            break;
+          height++;
         }
+
+        row &= ~mask;
+        for (int dv = 1; dv < height; ++dv)
+          rows[v + dv] &= uint16_t(~mask);
+
+        glm::ivec3 origin;
+        origin[axis] = slice;
+        origin[uAxis] = u;
+        origin[vAxis] = v;
+
+        glm::ivec3 quadSize(1);
+        quadSize[uAxis] = width;
+        quadSize[vAxis] = height;
+
+        addQuad(textureData, block, face, origin + sectionOrigin, quadSize, ambientOcclusion);
       }
-  return true;
+    }
+  }
 }
-/*
-bool MeshGenerator::generateMesh(World *world, BlockDataSO &textureData, const std::shared_ptr<ChunkData> &chunk)
+
+void MeshGenerator::prepareLodNeighborhood(const ChunkNeighborhood &blocks, ChunkNeighborhood &target)
 {
-  vertices.clear();
-  indices.clear();
-  uint32_t indexCount = 0;
+  target = blocks;
 
-  for (int dir = 0; dir < 6; ++dir)
+  int scale = 1 << blocks.lodLevel;
+  if (scale > 1)
   {
-    greedyMeshDirection(world, textureData, chunk, dir, indexCount);
-  }
+    for (int section = 0; section < ChunkData::sectionCount; ++section)
+    {
+      if (blocks.sectionEmpty[section])
+        continue;
 
-  return true;
-}*/
+      int sectionBottom = section * ChunkData::sectionHeight;
+      for (int cellY = sectionBottom; cellY < sectionBottom + ChunkData::sectionHeight; cellY += scale)
+        for (int cellZ = 0; cellZ < ChunkData::chunkSize; cellZ += scale)
+          for (int cellX = 0; cellX < ChunkData::chunkSize; cellX += scale)
+          {
+            int counts[ChunkNeighborhood::blockTypeCount] = {};
+            for (int y = cellY; y < cellY + scale; ++y)
+              for (int z = cellZ; z < cellZ + scale; ++z)
+              {
+                const BlockType *row = &blocks.blocks[blocks.toIndex(cellX, y, z)];
+                for (int x = 0; x < scale; ++x)
+                  counts[static_cast<int>(row[x])]++;
+              }
 
-void MeshGenerator::greedyMeshDirection(World *world, BlockDataSO &textureData, const std::shared_ptr<ChunkData> &chunk, int face, uint32_t &indexCount)
+            BlockType majority = ChunkNeighborhood::majorityBlock(counts);
+
+            for (int y = cellY; y < cellY + scale; ++y)
+              for (int z = cellZ; z < cellZ + scale; ++z)
+              {
+                BlockType *row = &target.blocks[target.toIndex(cellX, y, z)];
+                std::fill(row, row + scale, majority);
+              }
+          }
+    }
+  }
+}
+
+int MeshGenerator::faceAmbientOcclusion(const ChunkNeighborhood &blocks, glm::ivec3 pos, int face) const
 {
+  if (!bakeAmbientOcclusion)
+    return 0xFF;
+
+  // per face and corner: the two edge neighbors and the diagonal neighbor in the layer in front of the face,
+  // as offsets into the neighborhood
+  struct CornerOffsets
+  {
+    int offsets[6][4][3];
+  };
+  static const CornerOffsets cornerOffsets = []
+  {
+    CornerOffsets table;
+    for (int face = 0; face < 6; ++face)
+    {
+      int axis = face / 2;
+      for (int vert = 0; vert < 4; ++vert)
+      {
+        glm::ivec3 uStep(0), vStep(0);
+        uStep[faceUAxis[axis]] = faceVertices[face][vert][faceUAxis[axis]] > 0 ? 1 : -1;
+        vStep[faceVAxis[axis]] = faceVertices[face][vert][faceVAxis[axis]] > 0 ? 1 : -1;
+
+        glm::ivec3 neighbors[3] = {directions[face] + uStep, directions[face] + vStep, directions[face] + uStep + vStep};
+        for (int n = 0; n < 3; ++n)
+          table.offsets[face][vert][n] = neighbors[n].x * ChunkNeighborhood::strideX + neighbors[n].y * ChunkNeighborhood::strideY + neighbors[n].z * ChunkNeighborhood::strideZ;
+      }
+    }
+    return table;
+  }();
+
+  const BlockType *block = &blocks.blocks[blocks.toIndex(pos.x, pos.y, pos.z)];
+  int ambientOcclusion = 0;
+  for (int vert = 0; vert < 4; ++vert)
+  {
+    const int *offsets = cornerOffsets.offsets[face][vert];
+    int side1 = isOccluder(block[offsets[0]]);
+    int side2 = isOccluder(block[offsets[1]]);
+    int corner = isOccluder(block[offsets[2]]);
+
+    int cornerValue = (side1 && side2) ? 0 : 3 - (side1 + side2 + corner);
+    ambientOcclusion |= cornerValue << (vert * 2);
+  }
+  return ambientOcclusion;
 }
+
+void MeshGenerator::addQuad(BlockDataSO &textureData, BlockType block, int face, glm::ivec3 origin, glm::ivec3 size, int ambientOcclusion)
+{
+  const TextureData &blockTexture = textureData.textureDataList.at(block);
+  glm::ivec2 tile = face == 2 ? blockTexture.up : (face == 3 ? blockTexture.down : blockTexture.side);
+  int tilesPerRow = static_cast<int>(std::round(1.0f / textureData.textureSizeX));
+  int tileIndex = tile.x + tile.y * tilesPerRow;
+
+  int axis = face / 2;
+  glm::ivec2 repeatCount(size[faceUAxis[axis]], size[faceVAxis[axis]]);
+
+  SectionMeshData &sectionMesh = sectionMeshes.back();
+  std::vector<VoxelVertex> &target = isTranslucent(block) ? sectionMesh.translucentVertices : sectionMesh.vertices;
+
+  // the shared index buffer splits quads along 0-2, start at corner 1 to split along 1-3 instead
+  // so the diagonal joins the brighter pair and the occlusion gradient stays symmetric
+  int cornerOcclusion[4];
+  for (int vert = 0; vert < 4; ++vert)
+    cornerOcclusion[vert] = (ambientOcclusion >> (vert * 2)) & 0x3;
+  int firstCorner = cornerOcclusion[1] + cornerOcclusion[3] > cornerOcclusion[0] + cornerOcclusion[2] ? 1 : 0;
+
+  // texture coordinates are derived from the corner in shaders/voxel.vert, the shader tiles them repeatCount times
+  for (int i = 0; i < 4; ++i)
+  {
+    int vert = (firstCorner + i) & 3;
+    glm::ivec3 vertexPos = glm::ivec3(glm::vec3(origin) + (faceVertices[face][vert] + 0.5f) * glm::vec3(size));
+    target.emplace_back(VoxelVertex::pack(vertexPos, face, vert, cornerOcclusion[vert], tileIndex, repeatCount));
+  }
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "noise.hpp"
+#include <cmath>
+#include <algorithm>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+  inline float floorOf(float a)
+  {
+    return std::floor(a);
+  }
+
+  inline float absOf(float a)
+  {
+    return std::abs(a);
+  }
+
+#if defined(__AVX2__)
+  struct Lanes
+  {
+    static const int width = 8;
+    __m256 v;
+    Lanes(__m256 v) : v(v) {}
+    Lanes(float f) : v(_mm256_set1_ps(f)) {}
+    static Lanes load(const float *p) { return _mm256_loadu_ps(p); }
+    void store(float *p) const { _mm256_storeu_ps(p, v); }
+  };
+
+  inline Lanes operator+(Lanes a, Lanes b) { return _mm256_add_ps(a.v, b.v); }
+  inline Lanes operator-(Lanes a, Lanes b) { return _mm256_sub_ps(a.v, b.v); }
+  inline Lanes operator*(Lanes a, Lanes b) { return _mm256_mul_ps(a.v, b.v); }
+  inline Lanes operator/(Lanes a, Lanes b) { return _mm256_div_ps(a.v, b.v); }
+  inline Lanes floorOf(Lanes a) { return _mm256_floor_ps(a.v); }
+  inline Lanes absOf(Lanes a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+#elif defined(__SSE2__)
+  struct Lanes
+  {
+    static const int width = 4;
+    __m128 v;
+    Lanes(__m128 v) : v(v) {}
+    Lanes(float f) : v(_mm_set1_ps(f)) {}
+    static Lanes load(const float *p) { return _mm_loadu_ps(p); }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+  };
+
+  inline Lanes operator+(Lanes a, Lanes b) { return _mm_add_ps(a.v, b.v); }
+  inline Lanes operator-(Lanes a, Lanes b) { return _mm_sub_ps(a.v, b.v); }
+  inline Lanes operator*(Lanes a, Lanes b) { return _mm_mul_ps(a.v, b.v); }
+  inline Lanes operator/(Lanes a, Lanes b) { return _mm_div_ps(a.v, b.v); }
+  inline Lanes floorOf(Lanes a)
+  {
+#if defined(__SSE4_1__)
+    return _mm_floor_ps(a.v);
+#else
+    // truncate, then step down where truncation rounded up; exact while |a| < 2^31
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmplt_ps(a.v, truncated), _mm_set1_ps(1.0f)));
+#endif
+  }
+  inline Lanes absOf(Lanes a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+#endif
+
+  // the kernel below is shared by the scalar and SIMD paths so both run the exact same operations
+
+  template <typename T>
+  T mod289(T x)
+  {
+    return x - T(289.0f) * floorOf(x / T(289.0f));
+  }
+
+  template <typename T>
+  T permute(T x)
+  {
+    T t = ((x * T(34.0f)) + T(1.0f)) * x;
+    return t - floorOf(t * T(1.0f / 289.0f)) * T(289.0f);
+  }
+
+  template <typename T>
+  T gradient(T cellX, T cellY, T offsetX, T offsetY)
+  {
+    T hash = permute(permute(cellX) + cellY);
+    T h = hash / T(41.0f);
+    T gradX = T(2.0f) * (h - floorOf(h)) - T(1.0f);
+    T gradY = absOf(gradX) - T(0.5f);
+    gradX = gradX - floorOf(gradX + T(0.5f));
+
+    T norm = T(1.79284291400159f) - T(0.85373472095314f) * (gradX * gradX + gradY * gradY);
+    gradX = gradX * norm;
+    gradY = gradY * norm;
+    return gradX * offsetX + gradY * offsetY;
+  }
+
+  template <typename T>
+  T fade(T t)
+  {
+    return t * t * t * (t * (t * T(6.0f) - T(15.0f)) + T(10.0f));
+  }
+
+  template <typename T>
+  T perlinKernel(T x, T y)
+  {
+    T floorX = floorOf(x);
+    T floorY = floorOf(y);
+    T fracX = x - floorX;
+    T fracY = y - floorY;
+    T fracX1 = fracX - T(1.0f);
+    T fracY1 = fracY - T(1.0f);
+
+    T cellX = mod289(floorX);
+    T cellY = mod289(floorY);
+    T cellX1 = mod289(floorX + T(1.0f));
+    T cellY1 = mod289(floorY + T(1.0f));
+
+    T n00 = gradient(cellX, cellY, fracX, fracY);
+    T n10 = gradient(cellX1, cellY, fracX1, fracY);
+    T n01 = gradient(cellX, cellY1, fracX, fracY1);
+    T n11 = gradient(cellX1, cellY1, fracX1, fracY1);
+
+    T fadeX = fade(fracX);
+    T fadeY = fade(fracY);
+    T nx0 = n00 * (T(1.0f) - fadeX) + n10 * fadeX;
+    T nx1 = n01 * (T(1.0f) - fadeX) + n11 * fadeX;
+    return T(2.3f) * (nx0 * (T(1.0f) - fadeY) + nx1 * fadeY);
+  }
+
+  // rotation of every octave, computed once instead of per sample
+  struct OctaveRotations
+  {
+    static const int count = 16;
+    float cosA[count];
+    float sinA[count];
+
+    OctaveRotations()
+    {
+      for (int i = 0; i < count; ++i)
+      {
+        double angle = i * 0.5f;
+        cosA[i] = static_cast<float>(std::cos(angle));
+        sinA[i] = static_cast<float>(std::sin(angle));
+      }
+    }
+  };
+
+  const OctaveRotations octaveRotations;
+}
+
+float perlinNoise(float x, float y)
+{
+  return perlinKernel(x, y);
+}
+
+void perlinNoiseBatch(const float *x, const float *y, float *result, int count)
+{
+  int i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; i + Lanes::width <= count; i += Lanes::width)
+  {
+    perlinKernel(Lanes::load(x + i), Lanes::load(y + i)).store(result + i);
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    result[i] = perlinKernel(x[i], y[i]);
+  }
+}
+
+int latticeSamples(int size, int spacing)
+{
+  return size / spacing + 1;
+}
+
+void bilinearUpsample(const float *lattice, int spacing, int size, float *result)
+{
+  int samples = latticeSamples(size, spacing);
+  float step = 1.0f / spacing;
+  for (int x = 0; x < size; ++x)
+  {
+    int cellX = x / spacing;
+    float tx = (x % spacing) * step;
+    const float *row0 = &lattice[cellX * samples];
+    const float *row1 = row0 + samples;
+    for (int z = 0; z < size; ++z)
+    {
+      int cellZ = z / spacing;
+      float tz = (z % spacing) * step;
+      float v0 = row0[cellZ] * (1.0f - tz) + row0[cellZ + 1] * tz;
+      float v1 = row1[cellZ] * (1.0f - tz) + row1[cellZ + 1] * tz;
+      result[x * size + z] = v0 * (1.0f - tx) + v1 * tx;
+    }
+  }
+}
+
+void fractalNoiseBatch(const float *x, const float *y, int count, int octaves, float lacunarity, const float *scale, const float *persistence, const float *amplitude, float *result,
+                       float offsetX, float offsetY)
+{
+  const int blockSize = 64;
+  float sampleX[blockSize];
+  float sampleY[blockSize];
+  float noise[blockSize];
+  float octaveAmplitude[blockSize];
+
+  for (int start = 0; start < count; start += blockSize)
+  {
+    int size = std::min(blockSize, count - start);
+    for (int i = 0; i < size; ++i)
+    {
+      result[start + i] = 0.0f;
+      octaveAmplitude[i] = amplitude ? amplitude[start + i] : 1.0f;
+    }
+
+    float frequency = 1.0f;
+    for (int octave = 0; octave < octaves; ++octave)
+    {
+      float cosA;
+      float sinA;
+      if (octave < OctaveRotations::count)
+      {
+        cosA = octaveRotations.cosA[octave];
+        sinA = octaveRotations.sinA[octave];
+      }
+      else
+      {
+        cosA = static_cast<float>(std::cos(static_cast<double>(octave * 0.5f)));
+        sinA = static_cast<float>(std::sin(static_cast<double>(octave * 0.5f)));
+      }
+
+      for (int i = 0; i < size; ++i)
+      {
+        float px = x[start + i];
+        float py = y[start + i];
+        sampleX[i] = (px * cosA - py * sinA) * frequency / scale[start + i] + offsetX;
+        sampleY[i] = (px * sinA + py * cosA) * frequency / scale[start + i] + offsetY;
+      }
+
+      perlinNoiseBatch(sampleX, sampleY, noise, size);
+
+      for (int i = 0; i < size; ++i)
+      {
+        result[start + i] += noise[i] * octaveAmplitude[i];
+        if (persistence)
+          octaveAmplitude[i] *= persistence[start + i];
+      }
+      frequency *= lacunarity;
+    }
+  }
+}
@@ -0,0 +1,159 @@
+#include "paletteStorage.hpp"
+#include <algorithm>
+#include <numeric>
+
+PaletteStorage::PaletteStorage(int size, BlockType initial) : size(size)
+{
+  palette.push_back(initial);
+  setBitsShift(0);
+}
+
+void PaletteStorage::setBitsShift(int newBitsShift)
+{
+  bitsShift = newBitsShift;
+  entriesShift = 6 - bitsShift;
+  entriesMask = (1 << entriesShift) - 1;
+  valueMask = (uint64_t(1) << (1 << bitsShift)) - 1;
+}
+
+void PaletteStorage::set(int index, BlockType type)
+{
+  if (data.empty() && palette[0] == type)
+    return;
+
+  uint64_t value = static_cast<uint64_t>(findOrAddPaletteEntry(type));
+
+  uint64_t &word = data[index >> entriesShift];
+  int shift = (index & entriesMask) << bitsShift;
+  word = (word & ~(valueMask << shift)) | (value << shift);
+}
+
+void PaletteStorage::fill(BlockType type)
+{
+  palette.assign(1, type);
+  setBitsShift(0);
+  data.clear();
+  data.shrink_to_fit();
+}
+
+void PaletteStorage::assign(const BlockType *blocks)
+{
+  int lookup[256];
+  std::fill(std::begin(lookup), std::end(lookup), -1);
+  palette.clear();
+  for (int i = 0; i < size; i++)
+  {
+    uint8_t type = static_cast<uint8_t>(blocks[i]);
+    if (lookup[type] < 0)
+    {
+      lookup[type] = static_cast<int>(palette.size());
+      palette.push_back(blocks[i]);
+    }
+  }
+
+  if (palette.size() == 1)
+  {
+    fill(palette[0]);
+    return;
+  }
+
+  int newBitsShift = 0;
+  while ((size_t(1) << (1 << newBitsShift)) < palette.size())
+    newBitsShift++;
+  setBitsShift(newBitsShift);
+  data.resize((size + entriesMask) >> entriesShift);
+  int entriesPerWord = entriesMask + 1;
+  int bitsPerEntry = 1 << bitsShift;
+  for (size_t w = 0; w < data.size(); w++)
+  {
+    // each word is built in a register, the last one may be partly past the end
+    uint64_t word = 0;
+    int first = static_cast<int>(w) * entriesPerWord;
+    int count = std::min(entriesPerWord, size - first);
+    for (int i = 0; i < count; i++)
+    {
+      word |= static_cast<uint64_t>(lookup[static_cast<uint8_t>(blocks[first + i])]) << (i * bitsPerEntry);
+    }
+    data[w] = word;
+  }
+}
+
+int PaletteStorage::findOrAddPaletteEntry(BlockType type)
+{
+  for (int i = 0; i < static_cast<int>(palette.size()); i++)
+  {
+    if (palette[i] == type)
+      return i;
+  }
+
+  palette.push_back(type);
+  if (data.empty())
+  {
+    setBitsShift(0);
+    data.assign((size + entriesMask) >> entriesShift, 0);
+  }
+  else if (palette.size() > valueMask + 1)
+  {
+    std::vector<int> identity(palette.size());
+    std::iota(identity.begin(), identity.end(), 0);
+    repack(bitsShift + 1, identity);
+  }
+  return static_cast<int>(palette.size()) - 1;
+}
+
+void PaletteStorage::repack(int newBitsShift, const std::vector<int> &remap)
+{
+  std::vector<uint64_t> oldData = std::move(data);
+  int oldBitsShift = bitsShift;
+  int oldEntriesShift = entriesShift;
+  int oldEntriesMask = entriesMask;
+  uint64_t oldValueMask = valueMask;
+
+  setBitsShift(newBitsShift);
+  data.assign((size + entriesMask) >> entriesShift, 0);
+
+  for (int i = 0; i < size; i++)
+  {
+    uint64_t value = (oldData[i >> oldEntriesShift] >> ((i & oldEntriesMask) << oldBitsShift)) & oldValueMask;
+    data[i >> entriesShift] |= static_cast<uint64_t>(remap[value]) << ((i & entriesMask) << bitsShift);
+  }
+}
+
+void PaletteStorage::compact()
+{
+  if (data.empty())
+    return;
+
+  std::vector<int> counts(palette.size(), 0);
+  for (int i = 0; i < size; i++)
+  {
+    counts[(data[i >> entriesShift] >> ((i & entriesMask) << bitsShift)) & valueMask]++;
+  }
+
+  std::vector<BlockType> usedPalette;
+  std::vector<int> remap(palette.size(), 0);
+  for (int i = 0; i < static_cast<int>(palette.size()); i++)
+  {
+    if (counts[i] > 0)
+    {
+      remap[i] = static_cast<int>(usedPalette.size());
+      usedPalette.push_back(palette[i]);
+    }
+  }
+
+  if (usedPalette.size() == 1)
+  {
+    fill(usedPalette[0]);
+    return;
+  }
+
+  int newBitsShift = 0;
+  while ((size_t(1) << (1 << newBitsShift)) < usedPalette.size())
+    newBitsShift++;
+
+  if (usedPalette.size() == palette.size() && newBitsShift == bitsShift)
+    return;
+
+  repack(newBitsShift, remap);
+  palette = std::move(usedPalette);
+}
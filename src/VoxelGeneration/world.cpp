@@ -1,10 +1,16 @@
 #include "world.hpp"
 #include "engine.hpp"
 #include <cstdlib>
-#include <glm/gtc/noise.hpp>
+#include "noise.hpp"
+#include <stdexcept>
 
-World::World() : textureDataSource(0.1f, 0.1f)
+World::World(WorldSeed seed, const std::string &saveDirectory, int parameterLatticeSpacing)
+    : textureDataSource(0.1f, 0.1f), seed(seed), parameterLatticeSpacing(parameterLatticeSpacing)
 {
+  // the lattice of a chunk has to end on its border, or sampleHeights reads past it
+  if (parameterLatticeSpacing < 1 || ChunkData::chunkSize % parameterLatticeSpacing != 0)
+    throw std::invalid_argument("The parameter lattice spacing must divide the chunk size");
+
   TextureData grassTexture;
   grassTexture.up = glm::vec2(0, 2);
   grassTexture.down = glm::vec2(1, 1);
@@ -101,10 +107,36 @@ World::World() : textureDataSource(0.1f, 0.1f)
 
   biomes.emplace_back("Null", BlockType::Nothing, BlockType::Nothing, BlockType::Nothing, BlockType::Nothing, -1, -1, -1, 0, 0, 0);
   biomes.emplace_back("Plains", BlockType::Grass_Dirt, BlockType::Sand, BlockType::Dirt, BlockType::Stone, 0.5f, 0.5f, 0.5f, 10, 0.4f, 1.2f);
-  biomes.emplace_back("Forest", BlockType::Grass_Dirt, BlockType::Sand, BlockType::Dirt, BlockType::Stone, 0.6f, 0.7f, 0.7f, 25, 0.5f, 2.0f);
+  biomes.emplace_back("Forest", BlockType::Grass_Dirt, BlockType::Sand, BlockType::Dirt, BlockType::Stone, 0.6f, 0.7f, 0.7f, 25, 0.5f, 2.0f, true);
   biomes.emplace_back("Desert", BlockType::Sand, BlockType::Sand, BlockType::Sand, BlockType::Stone, 0.7f, 0.3f, 0.4f, 15, 0.4f, 1.75f);
   biomes.emplace_back("Ocean", BlockType::Sand, BlockType::Sand, BlockType::Sand, BlockType::Stone, 0.5f, 0.6f, 0.2f, 10, 0.4f, 1.2f);
   biomes.emplace_back("Mountain", BlockType::Stone, BlockType::Sand, BlockType::Stone, BlockType::Stone, 0.3f, 0.2f, 0.9f, 90, 0.7f, 2.0f);
+  buildBiomeLookup();
+
+  if (!saveDirectory.empty())
+    chunkStorage = std::make_unique<ChunkStorage>(saveDirectory);
+}
+
+World::~World()
+{
+  // workers hold a pointer to this world, join them before the chunks go away
+  stopWorkers();
+
+  // the edits are already journaled, compacting them leaves the next session a short journal to replay
+  if (chunkStorage)
+    chunkStorage->compactJournal();
+}
+
+ResidencyStats World::residencyStats() const
+{
+  return residency.stats();
+}
+
+std::optional<ChunkIOStats> World::storageStats() const
+{
+  if (!chunkStorage)
+    return std::nullopt;
+  return chunkStorage->stats();
 }
 
 BlockType World::getBlock(int x, int y, int z) const
@@ -134,28 +166,191 @@ int World::setBlock(int x, int y, int z, BlockType type)
     return -1;
 
   std::lock_guard<std::mutex> lock(chunkMutex);
-  return it->second->setBlock(localPos.x, localPos.y, localPos.z, type);
+  BlockType before = it->second->getBlock(localPos.x, localPos.y, localPos.z);
+  int result = it->second->setBlock(localPos.x, localPos.y, localPos.z, type);
+  if (result != 0)
+    return result;
+  if (before != type && chunkStorage)
+    chunkStorage->recordEdit(chunkPos, {EditJournal::blockIndex(localPos.x, localPos.y, localPos.z), before, type});
+
+  // blocks on a chunk border also change the faces and corner occlusion of the neighbor chunks
+  const int last = ChunkData::chunkSize - 1;
+  for (int dz = -1; dz <= 1; ++dz)
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+      if ((dx == 0 && dz == 0) || (dx == -1 && localPos.x != 0) || (dx == 1 && localPos.x != last) || (dz == -1 && localPos.z != 0) || (dz == 1 && localPos.z != last))
+        continue;
+
+      auto neighbor = chunks.find(chunkPos + glm::ivec3(dx * ChunkData::chunkSize, 0, dz * ChunkData::chunkSize));
+      if (neighbor != chunks.end())
+        neighbor->second->markDirty(localPos.y);
+    }
+  chunkChanges++;
+  return result;
+}
+
+bool World::isSectionEmpty(int x, int y, int z) const
+{
+  if (y < 0 || y >= ChunkData::chunkHeight)
+    return true;
+
+  glm::ivec3 chunkPos = worldToChunkCoords(x, y, z);
+
+  std::lock_guard<std::mutex> lock(chunkMutex);
+  auto it = chunks.find(chunkPos);
+  if (it == chunks.end())
+  {
+    return true;
+  }
+  return it->second->isSectionEmpty(y / ChunkData::sectionHeight);
+}
+
+void World::buildNeighborhood(const glm::ivec3 &chunkPos, ChunkNeighborhood &neighborhood) const
+{
+  const int size = ChunkData::chunkSize;
+  neighborhood.clear(chunkPos);
+
+  std::lock_guard<std::mutex> lock(chunkMutex);
+  for (int dz = -1; dz <= 1; ++dz)
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+      auto it = chunks.find(chunkPos + glm::ivec3(dx * size, 0, dz * size));
+      if (it == chunks.end())
+        continue;
+
+      int srcX0 = dx < 0 ? size - 1 : 0;
+      int srcZ0 = dz < 0 ? size - 1 : 0;
+      int dstX0 = dx < 0 ? -1 : dx * size;
+      int dstZ0 = dz < 0 ? -1 : dz * size;
+      int width = dx == 0 ? size : 1;
+      int depth = dz == 0 ? size : 1;
+      // side neighbors are copied as they are drawn, so both sides of a border between levels cull
+      // against the same blocks and no skirts are needed; diagonals only feed ambient occlusion
+      int neighborLevel = it->second->lodLevel;
+      if (neighborLevel > 0 && (dx == 0) != (dz == 0))
+        neighborhood.copyCoarseFrom(*it->second, neighborLevel, srcX0, srcZ0, dstX0, dstZ0, width, depth);
+      else
+        neighborhood.copyFrom(*it->second, srcX0, srcZ0, dstX0, dstZ0, width, depth);
+
+      if (dx == 0 && dz == 0)
+      {
+        for (int section = 0; section < ChunkData::sectionCount; ++section)
+        {
+          neighborhood.sectionEmpty[section] = it->second->isSectionEmpty(section);
+        }
+        neighborhood.lodLevel = it->second->lodLevel;
+      }
+    }
+}
+
+int World::selectLodLevel(int currentLevel, float chunkDistance) const
+{
+  auto levelAt = [this](float distance)
+  {
+    int level = 0;
+    while (level < maxLodLevel && distance > (lodDistance << level))
+      level++;
+    return level;
+  };
+
+  // only switch once the distance is lodHysteresis past a boundary, so chunks on a boundary do not flip every frame
+  return std::clamp(currentLevel, levelAt(chunkDistance - lodHysteresis), levelAt(chunkDistance + lodHysteresis));
+}
+
+static const glm::ivec3 chunkSides[4] = {{ChunkData::chunkSize, 0, 0}, {-ChunkData::chunkSize, 0, 0}, {0, 0, ChunkData::chunkSize}, {0, 0, -ChunkData::chunkSize}};
+// side and diagonal neighbors, the diagonals only feed corner ambient occlusion
+static const glm::ivec3 chunkNeighbors[8] = {{ChunkData::chunkSize, 0, 0}, {-ChunkData::chunkSize, 0, 0}, {0, 0, ChunkData::chunkSize}, {0, 0, -ChunkData::chunkSize}, {ChunkData::chunkSize, 0, ChunkData::chunkSize}, {ChunkData::chunkSize, 0, -ChunkData::chunkSize}, {-ChunkData::chunkSize, 0, ChunkData::chunkSize}, {-ChunkData::chunkSize, 0, -ChunkData::chunkSize}};
+
+void World::setLodLevel(const glm::ivec3 &chunkPos, int lodLevel)
+{
+  std::lock_guard<std::mutex> lock(chunkMutex);
+  auto it = chunks.find(chunkPos);
+  if (it == chunks.end())
+    return;
+
+  it->second->lodLevel = lodLevel;
+  it->second->dirtySections = ChunkData::allSections;
+
+  // the side neighbors cull against this chunk as it is drawn
+  for (const glm::ivec3 &side : chunkSides)
+  {
+    auto neighbor = chunks.find(chunkPos + side);
+    if (neighbor != chunks.end())
+      neighbor->second->dirtySections = ChunkData::allSections;
+  }
+  chunkChanges++;
+}
+
+bool World::chunkNeedsUpdate(const glm::ivec3 &chunkPos) const
+{
+  std::lock_guard<std::mutex> lock(chunkMutex);
+  if (chunksLoading.count(chunkPos))
+    return false;
+  auto it = chunks.find(chunkPos);
+  return it == chunks.end() || (it->second->dirtySections != 0 && neighborsLoaded(chunkPos));
+}
+
+bool World::neighborsLoaded(const glm::ivec3 &chunkPos) const
+{
+  for (const glm::ivec3 &neighbor : chunkNeighbors)
+  {
+    if (chunks.find(chunkPos + neighbor) == chunks.end())
+      return false;
+  }
+  return true;
 }
 
 void World::loadChunk(const glm::ivec3 &chunkPos)
 {
-  // check if chunk is stored in disk
-  // if so, then load
-  // else, generate new chunk
-  if (!hasChunk(chunkPos))
+  if (hasChunk(chunkPos))
   {
-    generateChunk(chunkPos);
+    residency.countHot(true);
+    return;
   }
+
+  residency.countHot(false);
+  std::shared_ptr<ChunkData> chunk = residency.promote(chunkPos);
+  if (!chunk)
+  {
+    ChunkPayload payload;
+    if (chunkStorage)
+    {
+      payload = chunkStorage->readAndWait(chunkPos);
+      residency.countDisk(payload.size != 0 || !payload.journalEdits.empty());
+    }
+    chunk = ChunkStorage::rebuild(chunkPos, payload, [this, &chunkPos]()
+                                  { return generateChunkData(chunkPos); });
+  }
+  std::lock_guard<std::mutex> lock(chunkMutex);
+  chunks.emplace(chunkPos, std::move(chunk));
 }
 
 bool World::hasChunk(const glm::ivec3 &chunkPos) const
 {
+  std::lock_guard<std::mutex> lock(chunkMutex);
   return chunks.find(chunkPos) != chunks.end();
 }
 
 void World::unloadChunk(const glm::ivec3 &chunkPos)
 {
-  // store chunk in disk
+  auto it = chunks.find(chunkPos);
+  if (it != chunks.end())
+  {
+    std::shared_ptr<ChunkData> chunk = it->second;
+    // once the workers stopped the chunk simply stays uncompressed in the warm tier
+    residency.demote(chunkPos, chunk);
+    jobSystem.submit([this, chunkPos, chunk]()
+                     { residency.compress(chunkPos, chunk); });
+  }
+
+  // the plans are only read while generating a chunk or its neighbors, drop the ones no loaded chunk can need
+  std::lock_guard<std::mutex> lock(treePlanMutex);
+  treePlans.erase(chunkPos);
+  for (const glm::ivec3 &neighbor : chunkNeighbors)
+  {
+    if (chunks.find(chunkPos + neighbor) == chunks.end())
+      treePlans.erase(chunkPos + neighbor);
+  }
 }
 
 int floorDivide(int numerator, int denominator)
@@ -193,6 +388,148 @@ glm::ivec3 World::worldToLocalCoords(int x, int y, int z) const
   return {localX, localY, localZ};
 }
 
+void World::startWorkers()
+{
+  jobSystem.start();
+}
+
+void World::stopWorkers()
+{
+  // the queued requests are cancelled so the workers only drain the short jobs behind them
+  chunkLoadQueue.clear();
+  jobSystem.shutdown();
+}
+
+void World::queueChunk(const glm::ivec3 &chunkPos)
+{
+  // one job per request, the job takes whichever request is nearest when it runs
+  if (chunkLoadQueue.push(chunkPos))
+  {
+    jobSystem.submit([this]()
+                     { processQueuedChunk(); });
+  }
+}
+
+void World::processQueuedChunk()
+{
+  glm::ivec3 pos;
+  if (!chunkLoadQueue.pop(pos))
+    return;
+
+  bool loaded;
+  bool generate;
+  {
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    loaded = chunks.find(pos) != chunks.end();
+    generate = !loaded && chunksLoading.insert(pos).second;
+  }
+
+  if (!generate)
+  {
+    if (loaded)
+      residency.countHot(true);
+    meshChunk(pos);
+    return;
+  }
+
+  // a recently unloaded chunk is decoded right here, only evicted ones are rebuilt from the disk
+  residency.countHot(false);
+  std::shared_ptr<ChunkData> chunk = residency.promote(pos);
+  if (chunk)
+  {
+    chunkLoaded(pos, std::move(chunk));
+    return;
+  }
+
+  if (!chunkStorage)
+  {
+    chunkLoaded(pos, generateChunkData(pos));
+    return;
+  }
+
+  // the worker moves on while the I/O thread reads, decoding or generating is a job of its own
+  chunkStorage->read(pos, [this, pos](ChunkPayload &&payload)
+                    {
+                      if (!jobSystem.submit([this, pos, payload = std::move(payload)]()
+                                            { finishLoading(pos, payload); }))
+                        abandonLoading(pos); });
+}
+
+void World::abandonLoading(const glm::ivec3 &pos)
+{
+  // the read finished after the workers stopped, the chunk is requested again once they run
+  {
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    chunksLoading.erase(pos);
+  }
+  chunkChanges++;
+}
+
+void World::finishLoading(const glm::ivec3 &pos, const ChunkPayload &payload)
+{
+  residency.countDisk(payload.size != 0 || !payload.journalEdits.empty());
+  chunkLoaded(pos, ChunkStorage::rebuild(pos, payload, [this, &pos]()
+                                         { return generateChunkData(pos); }));
+}
+
+void World::chunkLoaded(const glm::ivec3 &pos, std::shared_ptr<ChunkData> chunk)
+{
+  {
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    chunks.emplace(pos, std::move(chunk));
+    chunksLoading.erase(pos);
+  }
+  chunkChanges++;
+
+  // the new chunk may complete the neighborhood of itself and of the chunks around it
+  queueMeshing(pos);
+  for (const glm::ivec3 &neighbor : chunkNeighbors)
+  {
+    queueMeshing(pos + neighbor);
+  }
+}
+
+void World::queueMeshing(const glm::ivec3 &chunkPos)
+{
+  {
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    auto it = chunks.find(chunkPos);
+    if (it == chunks.end() || it->second->dirtySections == 0 || !neighborsLoaded(chunkPos))
+      return;
+  }
+
+  jobSystem.submit([this, chunkPos]()
+                   { meshChunk(chunkPos); });
+}
+
+void World::meshChunk(const glm::ivec3 &chunkPos)
+{
+  static thread_local MeshGenerator threadMeshGenerator;
+
+  // claims the dirty sections, only once every neighbor exists so borders are never meshed against Nothing
+  uint16_t dirtySections = 0;
+  std::shared_ptr<ChunkData> chunk;
+  {
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    auto it = chunks.find(chunkPos);
+    if (it == chunks.end() || !neighborsLoaded(chunkPos))
+      return;
+
+    chunk = it->second;
+    dirtySections = chunk->dirtySections;
+    chunk->dirtySections = 0;
+  }
+
+  if (dirtySections != 0)
+  {
+    threadMeshGenerator.meshingMode = meshingMode;
+    threadMeshGenerator.bufferPool = &meshBufferPool;
+    threadMeshGenerator.generateMesh(this, textureDataSource, chunk, dirtySections);
+
+    completedMeshes.push({chunkPos, std::move(threadMeshGenerator.sectionMeshes)});
+  }
+}
+
 void World::renderChunk(Engine *engine, std::string identifier, const glm::ivec3 &chunkPos)
 {
   loadChunk(chunkPos);
@@ -202,39 +539,47 @@ void World::renderChunk(Engine *engine, std::string identifier, const glm::ivec3
   MaterialData ground;
   ground.diffuseColor = {0.5, 0.5, 0.5};
   ground.hasTexture = 1;
-  engine->addMeshToObject(identifier, ground, "textures/tiles.png", meshGenerator.vertices, meshGenerator.indices);
+  MaterialData water = ground;
+  water.opacity = 0.75f;
+
+  glm::vec2 tileSize(textureDataSource.textureSizeX, textureDataSource.textureSizeY);
+  for (const SectionMeshData &sectionMesh : meshGenerator.sectionMeshes)
+  {
+    engine->setVoxelSectionMesh(identifier, sectionMesh.section, ground, tileSize, sectionMesh.vertices);
+    engine->setVoxelSectionMesh(identifier, sectionMesh.section, water, tileSize, sectionMesh.translucentVertices, true);
+  }
 }
 
-std::pair<float, Biome> World::getBiome(float temperature, float humidity, float elevation)
+std::pair<float, BiomeId> World::getBiome(float temperature, float humidity, float elevation) const
 {
   float closestDistance = std::numeric_limits<float>::max();
-  const Biome *closestBiome = nullptr;
+  BiomeId closestBiome = 0;
 
-  for (const Biome &biome : biomes)
+  for (size_t id = 0; id < biomes.size(); ++id)
   {
-
+    const Biome &biome = biomes[id];
     float distSq = (temperature - biome.temp) * (temperature - biome.temp) + (humidity - biome.humidity) * (humidity - biome.humidity) + ((elevation - biome.elevation) * (elevation - biome.elevation));
 
     if (distSq < closestDistance)
     {
       closestDistance = distSq;
-      closestBiome = &biome;
+      closestBiome = static_cast<BiomeId>(id);
     }
   }
 
-  return {closestDistance, *closestBiome};
+  return {closestDistance, closestBiome};
 }
 
-std::pair<float, Biome> World::getBiomeSecondary(float temperature, float humidity, float elevation)
+std::pair<float, BiomeId> World::getBiomeSecondary(float temperature, float humidity, float elevation) const
 {
   float closestDistance = std::numeric_limits<float>::max();
   float secondClosestDistance = std::numeric_limits<float>::max();
-  const Biome *closestBiome = nullptr;
-  const Biome *secondClosestBiome = nullptr;
+  BiomeId closestBiome = 0;
+  BiomeId secondClosestBiome = 0;
 
-  for (const Biome &biome : biomes)
+  for (size_t id = 0; id < biomes.size(); ++id)
   {
-
+    const Biome &biome = biomes[id];
     float distSq = (temperature - biome.temp) * (temperature - biome.temp) + (humidity - biome.humidity) * (humidity - biome.humidity) + (elevation - biome.elevation) * (elevation - biome.elevation);
 
     if (distSq < secondClosestDistance)
@@ -243,94 +588,231 @@ std::pair<float, Biome> World::getBiomeSecondary(float temperature, float humidi
       secondClosestBiome = closestBiome;
 
       closestDistance = distSq;
-      closestBiome = &biome;
+      closestBiome = static_cast<BiomeId>(id);
     }
     else if (distSq < closestDistance)
     {
       secondClosestDistance = distSq;
-      secondClosestBiome = &biome;
+      secondClosestBiome = static_cast<BiomeId>(id);
     }
   }
 
-  return {secondClosestDistance, *secondClosestBiome};
+  return {secondClosestDistance, secondClosestBiome};
 }
 
-float getPerlinNoise(float x, float y, int octaves, float persistence, float lacunarity, float scale, float amplitude = 1.0f)
+BiomeId World::lookupBiome(float temperature, float humidity, float elevation) const
 {
-  float frequency = 1.0f;
-  float noiseHeight = 0.0f;
+  if (temperature >= 0.0f && humidity >= 0.0f && elevation >= 0.0f)
+  {
+    int t = static_cast<int>(temperature * biomeLookupSize);
+    int h = static_cast<int>(humidity * biomeLookupSize);
+    int e = static_cast<int>(elevation * biomeLookupSize);
+    if (t < biomeLookupSize && h < biomeLookupSize && e < biomeLookupSize)
+    {
+      BiomeId id = biomeLookup[(t * biomeLookupSize + h) * biomeLookupSize + e];
+      if (id != mixedBiomeCell)
+        return id;
+    }
+  }
+  return getBiome(temperature, humidity, elevation).second;
+}
+
+void World::buildBiomeLookup()
+{
+  if (biomes.size() >= mixedBiomeCell)
+    throw std::runtime_error("Too many biomes for the biome lookup table");
+
+  const int corners = biomeLookupSize + 1;
+  auto cornerIndex = [corners](int t, int h, int e)
+  {
+    return (t * corners + h) * corners + e;
+  };
+
+  float step = 1.0f / biomeLookupSize;
+  std::vector<BiomeId> cornerBiomes(corners * corners * corners);
+  for (int t = 0; t < corners; ++t)
+    for (int h = 0; h < corners; ++h)
+      for (int e = 0; e < corners; ++e)
+        cornerBiomes[cornerIndex(t, h, e)] = getBiome(t * step, h * step, e * step).second;
+
+  // the region closest to one biome is convex, so a cell whose eight corners agree lies inside it
+  biomeLookup.assign(biomeLookupSize * biomeLookupSize * biomeLookupSize, mixedBiomeCell);
+  for (int t = 0; t < biomeLookupSize; ++t)
+    for (int h = 0; h < biomeLookupSize; ++h)
+      for (int e = 0; e < biomeLookupSize; ++e)
+      {
+        BiomeId id = cornerBiomes[cornerIndex(t, h, e)];
+        bool uniform = true;
+        for (int corner = 1; corner < 8 && uniform; ++corner)
+        {
+          uniform = cornerBiomes[cornerIndex(t + (corner & 1), h + ((corner >> 1) & 1), e + (corner >> 2))] == id;
+        }
+        if (uniform)
+          biomeLookup[(t * biomeLookupSize + h) * biomeLookupSize + e] = id;
+      }
+}
 
-  for (int i = 0; i < octaves; i++)
+float edgeBias(float x, float strength = 2.0f)
+{
+  return pow(x, strength) / (pow(x, strength) + pow(1.0f - x, strength));
+}
+
+namespace
+{
+  const int columnCount = ChunkData::chunkSize * ChunkData::chunkSize;
+
+  // every noise field and the tree placement get their own stream of seed bits
+  enum SeedStream : uint64_t
   {
-    float angle = i * 0.5f;
-    float cosA = cos(angle);
-    float sinA = sin(angle);
+    TemperatureStream,
+    HumidityStream,
+    ElevationStream,
+    PersistanceStream,
+    ScaleStream,
+    BaseStream,
+    AmplitudeStream,
+    HeightStream,
+    TreeStream
+  };
+
+  // shifts a field by up to 65535 blocks per axis, small enough for the sample coordinates to stay exact floats
+  glm::ivec2 fieldOffset(WorldSeed seed, SeedStream stream, int baseX, int baseZ)
+  {
+    uint64_t bits = mixSeed(seed, stream);
+    return {baseX + static_cast<int>(bits & 0xFFFF), baseZ + static_cast<int>((bits >> 16) & 0xFFFF)};
+  }
+
+  // noise coordinates of the whole 16x16 column grid, column index = x * chunkSize + z
+  void sampleGrid(const glm::ivec3 &chunkPos, glm::ivec2 offset, float frequency, float *columnX, float *columnZ)
+  {
+    for (int x = 0; x < ChunkData::chunkSize; ++x)
+      for (int z = 0; z < ChunkData::chunkSize; ++z)
+      {
+        columnX[x * ChunkData::chunkSize + z] = static_cast<float>(chunkPos.x + x + offset.x) * frequency;
+        columnZ[x * ChunkData::chunkSize + z] = static_cast<float>(chunkPos.z + z + offset.y) * frequency;
+      }
+  }
 
-    float sampleX = (x * cosA - y * sinA) * frequency / scale;
-    float sampleY = (x * sinA + y * cosA) * frequency / scale;
+  // single octave fields with periods of hundreds of blocks, sampled on the parameter lattice when spacing > 1
+  void octaveGrid(const glm::ivec3 &chunkPos, glm::ivec2 offset, float scale, int spacing, float *result)
+  {
+    float scales[columnCount];
+    std::fill(scales, scales + columnCount, scale);
+    if (spacing <= 1)
+    {
+      float columnX[columnCount];
+      float columnZ[columnCount];
+      sampleGrid(chunkPos, offset, 1.0f, columnX, columnZ);
+      fractalNoiseBatch(columnX, columnZ, columnCount, 1, 1.0f, scales, nullptr, nullptr, result);
+      return;
+    }
 
-    float perlinValue = glm::perlin(glm::vec2(sampleX, sampleY));
-    noiseHeight += perlinValue * amplitude;
+    int samples = latticeSamples(ChunkData::chunkSize, spacing);
+    float latticeX[columnCount];
+    float latticeZ[columnCount];
+    float lattice[columnCount];
+    for (int x = 0; x < samples; ++x)
+      for (int z = 0; z < samples; ++z)
+      {
+        latticeX[x * samples + z] = static_cast<float>(chunkPos.x + x * spacing + offset.x);
+        latticeZ[x * samples + z] = static_cast<float>(chunkPos.z + z * spacing + offset.y);
+      }
+    fractalNoiseBatch(latticeX, latticeZ, samples * samples, 1, 1.0f, scales, nullptr, nullptr, lattice);
+    bilinearUpsample(lattice, spacing, ChunkData::chunkSize, result);
+  }
 
-    amplitude *= persistence;
-    frequency *= lacunarity;
+  uint64_t chunkKey(const glm::ivec3 &chunkPos)
+  {
+    return static_cast<uint64_t>(static_cast<uint32_t>(chunkPos.x)) << 32 | static_cast<uint32_t>(chunkPos.z);
   }
+}
 
-  return noiseHeight;
+void World::sampleClimate(const glm::ivec3 &chunkPos, ChunkColumns &columns) const
+{
+  float columnX[columnCount];
+  float columnZ[columnCount];
+  float temperatures[columnCount];
+  float humidities[columnCount];
+  float elevations[columnCount];
+  sampleGrid(chunkPos, fieldOffset(seed, TemperatureStream, 140000, 150000), 0.005f, columnX, columnZ);
+  perlinNoiseBatch(columnX, columnZ, temperatures, columnCount);
+  sampleGrid(chunkPos, fieldOffset(seed, HumidityStream, 2000, 12000), 0.001f, columnX, columnZ);
+  perlinNoiseBatch(columnX, columnZ, humidities, columnCount);
+  sampleGrid(chunkPos, fieldOffset(seed, ElevationStream, 20200, 18000), 0.006f, columnX, columnZ);
+  perlinNoiseBatch(columnX, columnZ, elevations, columnCount);
+
+  columns.hasTrees = false;
+  for (int column = 0; column < columnCount; ++column)
+  {
+    float temperature = (temperatures[column] + 1) / 2;
+    float humidity = (humidities[column] + 1) / 2;
+    float elevation = (elevations[column] + 1) / 2;
+    columns.biome[column] = lookupBiome(temperature, humidity, elevation);
+    columns.hasTrees = columns.hasTrees || biomes[columns.biome[column]].hasTrees;
+  }
 }
 
-float edgeBias(float x, float strength = 2.0f)
+void World::sampleHeights(const glm::ivec3 &chunkPos, ChunkColumns &columns) const
 {
-  return pow(x, strength) / (pow(x, strength) + pow(1.0f - x, strength));
+  float persistances[columnCount];
+  float scales[columnCount];
+  float bases[columnCount];
+  float amplitudes[columnCount];
+  octaveGrid(chunkPos, fieldOffset(seed, PersistanceStream, 10000, 0), 170, parameterLatticeSpacing, persistances);
+  // the scale divides the absolute noise coordinates of every height octave, so an interpolated scale would
+  // shift the fine octaves further the farther the chunk is from the noise origin, it is sampled per column
+  octaveGrid(chunkPos, fieldOffset(seed, ScaleStream, 20200, 2000), 400, 1, scales);
+  octaveGrid(chunkPos, fieldOffset(seed, BaseStream, 1000, 2000), 1800, parameterLatticeSpacing, bases);
+  octaveGrid(chunkPos, fieldOffset(seed, AmplitudeStream, 1000, 20000), 600, parameterLatticeSpacing, amplitudes);
+  for (int column = 0; column < columnCount; ++column)
+  {
+    persistances[column] = std::pow((persistances[column] + 1) / 2, 2) * 0.3f + 0.4f;
+    scales[column] = (scales[column] + 1) / 2 * 300 + 300;
+    bases[column] = (bases[column] + 1) / 2 * 120 + 60;
+    amplitudes[column] = edgeBias((amplitudes[column] + 1) / 2, 3) * 120 + 5;
+  }
+
+  float columnX[columnCount];
+  float columnZ[columnCount];
+  float heights[columnCount];
+  // the seed moves the height octaves in noise space, up to 256 units, which covers the period of the noise;
+  // moved in world space every column's scale would stretch the shift differently and roughen the terrain
+  glm::ivec2 heightOffset = fieldOffset(seed, HeightStream, 0, 0);
+  sampleGrid(chunkPos, glm::ivec2(0), 1.0f, columnX, columnZ);
+  fractalNoiseBatch(columnX, columnZ, columnCount, 8, 2.0f, scales, persistances, amplitudes, heights, heightOffset.x / 256.0f, heightOffset.y / 256.0f);
+  for (int column = 0; column < columnCount; ++column)
+  {
+    columns.terrainHeight[column] = static_cast<int>(bases[column] + heights[column]);
+  }
 }
 
 void World::generateChunk(const glm::ivec3 &chunkPos)
+{
+  std::shared_ptr<ChunkData> chunk = generateChunkData(chunkPos);
+  std::lock_guard<std::mutex> lock(chunkMutex);
+  chunks.emplace(chunkPos, std::move(chunk));
+}
+
+std::shared_ptr<ChunkData> World::generateChunkData(const glm::ivec3 &chunkPos)
 {
   auto chunk = std::make_shared<ChunkData>(glm::vec3(chunkPos));
+  chunk->fill(BlockType::Air);
 
-  int waterLevel = 60;
+  ChunkColumns columns;
+  sampleClimate(chunkPos, columns);
+  sampleHeights(chunkPos, columns);
 
-  bool forestChunk = false;
   for (int x = 0; x < ChunkData::chunkSize; ++x)
   {
     for (int z = 0; z < ChunkData::chunkSize; ++z)
     {
-      int worldX = chunkPos.x + x;
-      int worldZ = chunkPos.z + z;
-      /*
-      float temperature = (glm::perlin(glm::vec2(worldX + 120000, worldZ + 150000) * 0.005f) + 1) / 2;
-      float humidity = (glm::perlin(glm::vec2(worldX + 8000, worldZ + 12000) * 0.001f) + 1) / 2;
-      float elevation = (glm::perlin(glm::vec2(worldX + 10200, worldZ + 18000) * 0.006f) + 1) / 2;
-      // std::cout << "Temp: " + std::to_string(temperature) + " Hum: " + std::to_string(humidity) + " Elev: " + std::to_string(elevation) + "\n";
-
-      auto [distance, biome] = getBiome(temperature, humidity, elevation);
-      auto [distance2, biome2] = getBiomeSecondary(temperature, humidity, elevation);
-      float blendFactor = std::clamp((distance / (distance + distance2)), 0.0f, 1.0f);
-      // blendFactor = blendFactor * blendFactor * (3 - 2 * blendFactor);
-
-      int terrainHeight;
-      // float noiseValue = getPerlinNoise(worldX, worldZ, 8, 0.7f, 2.0f, 400);
-      float noiseValue = getPerlinNoise(worldX, worldZ, 8, glm::mix(biome.persistance, biome2.persistance, blendFactor), glm::mix(biome.lacunarity, biome2.lacunarity, blendFactor), 400);
-      terrainHeight = (elevation * 80 + 40) + static_cast<int>(noiseValue * glm::mix(biome.heightDiff, biome2.heightDiff, blendFactor));
-*/
-      float temperature = (glm::perlin(glm::vec2(worldX + 140000, worldZ + 150000) * 0.005f) + 1) / 2;
-      float humidity = (glm::perlin(glm::vec2(worldX + 2000, worldZ + 12000) * 0.001f) + 1) / 2;
-      float elevation = (glm::perlin(glm::vec2(worldX + 20200, worldZ + 18000) * 0.006f) + 1) / 2;
-      auto [distance, biome] = getBiome(temperature, humidity, elevation);
-      if (biome.name == "Forest")
-      {
-        forestChunk = true;
-      }
-      int terrainHeight;
-      // float noiseValue = getPerlinNoise(worldX, worldZ, 8, 0.7f, 2.0f, 400);
-      float persistance = std::pow((getPerlinNoise(worldX + 10000, worldZ, 1, 1.0f, 1.0f, 170) + 1) / 2, 2) * 0.3f + 0.4f;
-      float scale = (getPerlinNoise(worldX + 20200, worldZ + 2000, 1, 1.0f, 1.0f, 400) + 1) / 2 * 300 + 300;
-      float base = (getPerlinNoise(worldX + 1000, worldZ + 2000, 1, 1.0f, 1.0f, 1800) + 1) / 2 * 120 + 60;
-
-      float amplitude = edgeBias((getPerlinNoise(worldX + 1000, worldZ + 20000, 1, 1.0f, 1.0f, 600) + 1) / 2, 3) * 120 + 5;
-      float noiseValue = getPerlinNoise(worldX, worldZ, 8, persistance, 2.0f, scale, amplitude);
-      terrainHeight = static_cast<int>(base + noiseValue);
-      for (int y = 0; y < ChunkData::chunkHeight; ++y)
+      int column = x * ChunkData::chunkSize + z;
+      const Biome &biome = biomes[columns.biome[column]];
+      int terrainHeight = columns.terrainHeight[column];
+      int columnTop = std::max(terrainHeight, waterLevel);
+      if (columnTop > ChunkData::chunkHeight)
+        columnTop = ChunkData::chunkHeight;
+      for (int y = 0; y < columnTop; ++y)
       {
         if (y < terrainHeight - 3)
         {
@@ -347,111 +829,134 @@ void World::generateChunk(const glm::ivec3 &chunkPos)
           else
             chunk->setBlock(x, y, z, biome.surfaceBlock);
         }
-        else if (y < waterLevel)
-        {
-          chunk->setBlock(x, y, z, BlockType::Water);
-        }
         else
         {
-          chunk->setBlock(x, y, z, BlockType::Air);
+          chunk->setBlock(x, y, z, BlockType::Water);
         }
       }
     }
   }
 
-  for (BlockQueueData &block : blocksQueue[chunkPos])
+  // Trees reach at most 14 blocks past their column, so only the eight neighbors grow into this
+  // chunk. Their trees are planned again here instead of being written by the neighbor, which keeps
+  // every chunk independent of load order. The chunk's own trees go last and win overlaps.
+  for (const glm::ivec3 &neighbor : chunkNeighbors)
   {
-    chunk->setBlock(block.blockPos.x, block.blockPos.y, block.blockPos.z, block.blockType);
+    for (const TreePlacement &tree : plannedTrees(chunkPos + neighbor))
+    {
+      stampTree(*chunk, neighbor, tree);
+    }
   }
-
-  if (forestChunk)
+  std::vector<TreePlacement> trees = planTrees(chunkPos, columns);
+  for (const TreePlacement &tree : trees)
   {
-    std::mt19937 rng(chunkPos.x * 73856093 ^ chunkPos.z * 19349663);
-    std::uniform_int_distribution<int> dist(0, ChunkData::chunkSize - 1);
-    for (int i = 0; i < ChunkData::chunkSize / 3; ++i)
-    {
-      int x = dist(rng);
-      int z = dist(rng);
+    stampTree(*chunk, glm::ivec3(0), tree);
+  }
+  {
+    std::lock_guard<std::mutex> lock(treePlanMutex);
+    treePlans.emplace(chunkPos, std::move(trees));
+  }
 
-      auto [y, type] = getSurfaceBlock(chunk, x, z);
-      if (y == -1)
-        continue;
-      if (type != BlockType::Grass_Dirt)
-        continue;
+  chunk->compact();
+  return chunk;
+}
 
-      generateTreeAt(chunk, {x, y + 1, z}, rng);
-    }
+std::vector<TreePlacement> World::plannedTrees(const glm::ivec3 &chunkPos)
+{
+  {
+    std::lock_guard<std::mutex> lock(treePlanMutex);
+    auto it = treePlans.find(chunkPos);
+    if (it != treePlans.end())
+      return it->second;
   }
 
-  std::lock_guard<std::mutex> lock(chunkMutex);
-  chunks.emplace(chunkPos, std::move(chunk));
+  // only the climate is needed to know the chunk has no trees at all
+  ChunkColumns columns;
+  sampleClimate(chunkPos, columns);
+  if (columns.hasTrees)
+    sampleHeights(chunkPos, columns);
+  std::vector<TreePlacement> trees = planTrees(chunkPos, columns);
+
+  std::lock_guard<std::mutex> lock(treePlanMutex);
+  treePlans.emplace(chunkPos, trees);
+  return trees;
 }
 
-void World::generateTreeAt(std::shared_ptr<ChunkData> chunk, const glm::ivec3 &position, std::mt19937 &rng)
+std::vector<TreePlacement> World::planTrees(const glm::ivec3 &chunkPos, const ChunkColumns &columns) const
 {
+  std::vector<TreePlacement> trees;
+  if (!columns.hasTrees)
+    return trees;
 
-  std::uniform_int_distribution<int> trunkHeightDist(4, 40);
-  int trunkHeight = trunkHeightDist(rng);
-  int trunkWidth = 1;
-
-  if (trunkHeight > 11)
+  std::mt19937 rng(static_cast<uint32_t>(mixSeed(mixSeed(seed, TreeStream), chunkKey(chunkPos))));
+  std::uniform_int_distribution<int> dist(0, ChunkData::chunkSize - 1);
+  for (int i = 0; i < ChunkData::chunkSize / 3; ++i)
   {
-    std::uniform_int_distribution<int> trunkWidthDist(1, trunkHeight / 11);
-    trunkWidth = trunkWidthDist(rng);
+    int x = dist(rng);
+    int z = dist(rng);
+
+    // trees only grow where the terrain ends in grass above the water
+    int column = x * ChunkData::chunkSize + z;
+    int terrainHeight = columns.terrainHeight[column];
+    if (biomes[columns.biome[column]].surfaceBlock != BlockType::Grass_Dirt || terrainHeight <= waterLevel + 1 || terrainHeight > ChunkData::chunkHeight)
+      continue;
+
+    TreePlacement tree;
+    tree.position = {x, terrainHeight, z};
+
+    std::uniform_int_distribution<int> trunkHeightDist(4, 40);
+    tree.trunkHeight = trunkHeightDist(rng);
+    tree.trunkWidth = 1;
+
+    if (tree.trunkHeight > 11)
+    {
+      std::uniform_int_distribution<int> trunkWidthDist(1, tree.trunkHeight / 11);
+      tree.trunkWidth = trunkWidthDist(rng);
+    }
+    std::uniform_int_distribution<int> leafRadiusDist(3, 4 * tree.trunkWidth);
+    tree.leafRadius = leafRadiusDist(rng);
+    trees.push_back(tree);
   }
-  std::uniform_int_distribution<int> leafRadiusDist(3, 4 * trunkWidth);
-  int leafRadius = leafRadiusDist(rng);
+  return trees;
+}
 
-  for (int i = 0; i < trunkHeight; i++)
+void World::stampTree(ChunkData &chunk, const glm::ivec3 &sourceOffset, const TreePlacement &tree) const
+{
+  glm::ivec3 position = sourceOffset + tree.position;
+  int reach = std::max(tree.leafRadius, tree.trunkWidth);
+  if (position.x + reach < 0 || position.x - reach >= ChunkData::chunkSize || position.z + reach < 0 || position.z - reach >= ChunkData::chunkSize)
+    return;
+
+  // only the part inside the chunk is written, the chunk the rest falls in stamps the same tree itself
+  int minX = -position.x;
+  int maxX = ChunkData::chunkSize - 1 - position.x;
+  int minZ = -position.z;
+  int maxZ = ChunkData::chunkSize - 1 - position.z;
+
+  for (int i = 0; i < tree.trunkHeight; i++)
   {
-    for (int w = 0; w < trunkWidth; w++)
+    for (int w = std::max(0, minX); w <= std::min(tree.trunkWidth - 1, maxX); w++)
     {
-      for (int l = 0; l < trunkWidth; l++)
+      for (int l = std::max(0, minZ); l <= std::min(tree.trunkWidth - 1, maxZ); l++)
       {
-        int result = chunk->setBlock(position.x + w, position.y + i, position.z + l, BlockType::Tree_Trunk);
-        if (result == -1)
-        {
-          glm::vec3 pos = chunk->worldPosition + glm::ivec3(position.x + w, position.y + i, position.z + l);
-          result = setBlock(pos.x, pos.y, pos.z, BlockType::Tree_Trunk);
-          if (result == -1)
-          {
-            BlockQueueData block;
-            block.blockPos = worldToLocalCoords(pos.x, pos.y, pos.z);
-            block.blockType = BlockType::Tree_Trunk;
-
-            blocksQueue[worldToChunkCoords(pos.x, pos.y, pos.z)].emplace_back(block);
-          }
-        }
+        chunk.setBlock(position.x + w, position.y + i, position.z + l, BlockType::Tree_Trunk);
       }
     }
   }
 
-  int leafBaseY = position.y + trunkHeight - 2;
-  for (int dx = -leafRadius; dx <= leafRadius; ++dx)
+  int leafBaseY = position.y + tree.trunkHeight - 2;
+  for (int dx = std::max(-tree.leafRadius, minX); dx <= std::min(tree.leafRadius, maxX); ++dx)
   {
-    for (int dy = -leafRadius; dy <= leafRadius; ++dy)
+    for (int dy = -tree.leafRadius; dy <= tree.leafRadius; ++dy)
     {
-      for (int dz = -leafRadius; dz <= leafRadius; ++dz)
+      for (int dz = std::max(-tree.leafRadius, minZ); dz <= std::min(tree.leafRadius, maxZ); ++dz)
       {
         int dist = dx * dx + dy * dy + dz * dz;
-        if (dist < leafRadius * leafRadius)
+        if (dist < tree.leafRadius * tree.leafRadius)
         {
-          int result = chunk->setBlock(position.x + dx, leafBaseY + dy, position.z + dz, BlockType::Tree_Leafes_Solid);
-          if (result == -1)
-          {
-            glm::vec3 pos = chunk->worldPosition + glm::ivec3(position.x + dx, leafBaseY + dy, position.z + dz);
-            result = setBlock(pos.x, pos.y, pos.z, BlockType::Tree_Leafes_Solid);
-            if (result == -1)
-            {
-              BlockQueueData block;
-              block.blockPos = worldToLocalCoords(pos.x, pos.y, pos.z);
-              block.blockType = BlockType::Tree_Leafes_Solid;
-
-              blocksQueue[worldToChunkCoords(pos.x, pos.y, pos.z)].emplace_back(block);
-            }
-          }
+          chunk.setBlock(position.x + dx, leafBaseY + dy, position.z + dz, BlockType::Tree_Leafes_Solid);
         }
       }
     }
   }
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include "application.hpp"
+#include <iostream>
 
 std::vector<Vertex> getItemUIVertices(Item item)
 {
@@ -81,12 +82,29 @@ void Application::run()
     engine.createTextObject(std::to_string(i), " ", glm::vec3(engine.WIDTH / 2 - 320 + (i * 1.5f * 48), -924, -6), glm::vec3(0), glm::vec3(0.6f));
   }
 
-  world.startWorker();
+  frameScheduler.addSource(FramePriority::Upload, [this]()
+                           { return uploadNextMesh(&engine); });
+  frameScheduler.addSource(FramePriority::Background, [this]()
+                           { return queueMissingChunks(&engine); });
+  frameScheduler.addSource(FramePriority::Background, [this]()
+                           { return scanLoadedChunks(&engine); });
 
-  world.startWorker();
-  world.startWorker();
+  world.startWorkers();
   engine.run();
+  world.stopWorkers();
   engine.shutdown();
+  printChunkStats();
+}
+
+void Application::printChunkStats() const
+{
+  ResidencyStats tiers = world.residencyStats();
+  std::cerr << "Chunk residency: hot " << tiers.hotHits << " hits / " << tiers.hotMisses << " misses, warm " << tiers.warmHits << " / " << tiers.warmMisses << ", disk "
+            << tiers.diskHits << " / " << tiers.diskMisses << ", " << tiers.demotions << " demoted, " << tiers.evictions << " evicted, " << tiers.warmChunks << " warm chunks in "
+            << tiers.warmBytes / 1024 << " KB next to " << tiers.hotBytes / 1024 << " KB hot" << std::endl;
+  if (std::optional<ChunkIOStats> io = world.storageStats())
+    std::cerr << "Chunk I/O through " << io->backend << ": " << io->reads << " reads, " << io->writes << " writes, peak depth " << io->peakDepth << ", latency p50 "
+              << io->latencyP50Ms << " ms, p90 " << io->latencyP90Ms << " ms, p99 " << io->latencyP99Ms << " ms, max " << io->latencyMaxMs << " ms" << std::endl;
 }
 
 void Application::update(Engine *engine, float dt)
@@ -235,81 +253,180 @@ void Application::update(Engine *engine, float dt)
       rightMouseClick = false;
     }
   }
-  drawInventory();
+  frameScheduler.schedule(FramePriority::Interface, [this]()
+                          { drawInventory(); });
 
   glm::ivec3 playerChunk = world.worldToChunkCoords(engine->camera.Position.x, 0, engine->camera.Position.z);
+  world.chunkLoadQueue.setFocus(playerChunk, loadDistance());
+
+  scanFinishedThisFrame = false;
+  frameScheduler.runFrame();
+}
+
+static std::string chunkIdentifier(const glm::ivec3 &chunkPos)
+{
+  return std::to_string(chunkPos.x) + "|" + std::to_string(chunkPos.y) + "|" + std::to_string(chunkPos.z);
+}
+
+bool Application::uploadNextMesh(Engine *engine)
+{
+  CompletedData result;
+  if (!world.completedMeshes.pop(result))
+    return false;
 
-  int renderDistance = 4;
+  auto &[chunkPos, sections] = result;
 
-  for (int r = renderDistance; r >= 0; r--)
+  if (!world.hasChunk(chunkPos))
   {
-    for (int dx = -r; dx <= r; dx++)
-    {
-      int dz = r;
-      tryAddChunk(dx, dz, playerChunk);
-      if (r != 0)
-        tryAddChunk(dx, -dz, playerChunk);
-    }
+    world.meshBufferPool.release(std::move(sections));
+    return true;
+  }
 
-    for (int dz = -r + 1; dz <= r - 1; dz++)
-    {
-      int dx = r;
-      tryAddChunk(dx, dz, playerChunk);
-      if (r != 0)
-        tryAddChunk(-dx, dz, playerChunk);
-    }
+  std::string identifier = chunkIdentifier(chunkPos);
+  if (engine->gameObjects.find(identifier) == engine->gameObjects.end())
+  {
+    engine->createGameObject(identifier, chunkPos, glm::vec3(0), glm::vec3(1));
   }
 
-  for (auto it = world.chunks.begin(); it != world.chunks.end();)
+  MaterialData ground;
+  ground.diffuseColor = {0.5, 0.5, 0.5};
+  ground.hasTexture = 1;
+
+  MaterialData water = ground;
+  water.opacity = 0.75f;
+
+  // only the remeshed sections are swapped, the rest of the chunk keeps its buffers
+  glm::vec2 tileSize(world.textureDataSource.textureSizeX, world.textureDataSource.textureSizeY);
+  // the sections are owned here, so the upload takes no world lock the workers are waiting for
+  for (const SectionMeshData &sectionMesh : sections)
   {
-    glm::ivec3 chunkPos(it->first);
-    glm::vec3 floatPos(chunkPos);
-    glm::vec3 camPos(engine->camera.Position);
-    float distSquared = std::pow(camPos.x - floatPos.x, 2) + std::pow(camPos.z - floatPos.z, 2);
-    if (distSquared > std::pow((renderDistance * 1.5) * ChunkData::chunkSize, 2))
+    engine->setVoxelSectionMesh(identifier, sectionMesh.section, ground, tileSize, sectionMesh.vertices);
+    engine->setVoxelSectionMesh(identifier, sectionMesh.section, water, tileSize, sectionMesh.translucentVertices, true);
+  }
+  // the meshes only keep their GPU buffers, the vertex memory goes back to the workers
+  world.meshBufferPool.release(std::move(sections));
+  return true;
+}
+
+bool Application::queueMissingChunks(Engine *engine)
+{
+  if (loadOffsets.empty())
+  {
+    for (int r = 0; r <= loadDistance(); r++)
     {
-      std::lock_guard<std::mutex> lock(world.chunkDeletionMutex);
-      std::lock_guard<std::mutex> lock2(world.chunkMutex);
-      world.unloadChunk(chunkPos);
-      std::string identifier = std::to_string(chunkPos.x) + "|" + std::to_string(chunkPos.y) + "|" + std::to_string(chunkPos.z);
-      engine->removeGameObject(identifier);
-      it = world.chunks.erase(it);
+      for (int dz = -r; dz <= r; dz++)
+      {
+        // rows inside the ring only hold its two edge chunks
+        int step = std::abs(dz) == r ? 1 : 2 * r;
+        for (int dx = -r; dx <= r; dx += step)
+        {
+          loadOffsets.push_back({dx, dz});
+        }
+      }
     }
-    else
+  }
+
+  // a pass walks the square nearest ring first a slice at a time; the next one starts once the player
+  // entered another chunk, or once chunks were loaded, edited or changed level since the last one began
+  glm::ivec3 playerChunk = world.worldToChunkCoords(engine->camera.Position.x, 0, engine->camera.Position.z);
+  uint64_t changes = world.chunkChanges.load();
+  if (playerChunk != loadCenter || (loadIndex >= loadOffsets.size() && changes != loadChanges))
+  {
+    loadCenter = playerChunk;
+    loadChanges = changes;
+    loadIndex = 0;
+  }
+  if (loadIndex >= loadOffsets.size())
+    return false;
+
+  const size_t loadSlice = 128;
+  for (size_t end = std::min(loadIndex + loadSlice, loadOffsets.size()); loadIndex < end; ++loadIndex)
+  {
+    tryAddChunk(loadOffsets[loadIndex].x, loadOffsets[loadIndex].y, loadCenter);
+  }
+  // a finished pass ends the frame's polling, so at most one pass starts per frame
+  return loadIndex < loadOffsets.size();
+}
+
+bool Application::chunkOutOfRange(Engine *engine, const glm::ivec3 &chunkPos) const
+{
+  // the same square as the chunks loaded around the player, see queueMissingChunks
+  glm::ivec3 playerChunk = world.worldToChunkCoords(engine->camera.Position.x, 0, engine->camera.Position.z);
+  int offsetX = std::abs(chunkPos.x - playerChunk.x) / ChunkData::chunkSize;
+  int offsetZ = std::abs(chunkPos.z - playerChunk.z) / ChunkData::chunkSize;
+  return std::max(offsetX, offsetZ) > loadDistance() + unloadHysteresis;
+}
+
+bool Application::scanLoadedChunks(Engine *engine)
+{
+  // a pass walks a snapshot of the loaded chunks a slice at a time, at most one pass per frame
+  if (scanIndex >= scanPositions.size())
+  {
+    if (scanFinishedThisFrame)
+      return false;
+
+    scanPositions.clear();
+    scanIndex = 0;
+    scanBytes = 0;
+    std::lock_guard<std::mutex> lock(world.chunkMutex);
+    for (const auto &[chunkPos, chunk] : world.chunks)
     {
-      it++;
+      scanPositions.push_back(chunkPos);
     }
   }
 
-  CompletedData result;
-  const int maxUploadsPerFrame = 1;
-  int uploads = 0;
-  while (uploads < maxUploadsPerFrame && world.completedMeshes.pop(result))
+  const size_t scanSlice = 64;
+  glm::vec2 camPos(engine->camera.Position.x, engine->camera.Position.z);
+  for (size_t end = std::min(scanIndex + scanSlice, scanPositions.size()); scanIndex < end; ++scanIndex)
   {
-    auto &[chunkPos, vertices, indices] = result;
-
-    if (!world.hasChunk(chunkPos))
+    glm::ivec3 chunkPos = scanPositions[scanIndex];
+    if (chunkOutOfRange(engine, chunkPos))
     {
+      if (pendingUnloads.insert(chunkPos).second)
+      {
+        frameScheduler.schedule(FramePriority::Teardown, [this, engine, chunkPos]()
+                                { unloadChunk(engine, chunkPos); });
+      }
       continue;
     }
 
-    std::string identifier = std::to_string(chunkPos.x) + "|" + std::to_string(chunkPos.y) + "|" + std::to_string(chunkPos.z);
-    if (engine->gameObjects.find(identifier) != engine->gameObjects.end())
+    int currentLevel;
     {
-      std::lock_guard<std::mutex> lock(world.chunkDeletionMutex);
-      std::lock_guard<std::mutex> lock2(world.chunkMutex);
-      engine->removeGameObject(identifier);
+      std::lock_guard<std::mutex> lock(world.chunkMutex);
+      auto it = world.chunks.find(chunkPos);
+      if (it == world.chunks.end())
+        continue;
+      currentLevel = it->second->lodLevel;
+      scanBytes += it->second->memoryUsage();
     }
-    engine->createGameObject(identifier, chunkPos, glm::vec3(0), glm::vec3(1));
 
-    MaterialData ground;
-    ground.diffuseColor = {0.5, 0.5, 0.5};
-    ground.hasTexture = 1;
+    glm::vec2 centerOffset = glm::vec2(chunkPos.x, chunkPos.z) + glm::vec2(ChunkData::chunkSize / 2.0f) - camPos;
+    float chunkDistance = glm::length(centerOffset) / ChunkData::chunkSize;
+    int lodLevel = world.selectLodLevel(currentLevel, chunkDistance);
+    if (lodLevel != currentLevel)
+    {
+      world.setLodLevel(chunkPos, lodLevel);
+    }
+  }
 
-    engine->addVoxelMeshToObject(identifier, ground, "textures/tiles.png", vertices, indices);
+  scanFinishedThisFrame = scanIndex >= scanPositions.size();
+  if (scanFinishedThisFrame)
+    world.residency.setHotBytes(scanBytes);
+  return true;
+}
 
-    uploads++;
-  }
+void Application::unloadChunk(Engine *engine, const glm::ivec3 &chunkPos)
+{
+  pendingUnloads.erase(chunkPos);
+  // the player may have come back since the chunk was scheduled
+  if (!chunkOutOfRange(engine, chunkPos))
+    return;
+
+  std::lock_guard<std::mutex> lock(world.chunkDeletionMutex);
+  std::lock_guard<std::mutex> lock2(world.chunkMutex);
+  world.unloadChunk(chunkPos);
+  engine->removeGameObject(chunkIdentifier(chunkPos));
+  world.chunks.erase(chunkPos);
 }
 
 void Application::drawInventory()
@@ -375,6 +492,9 @@ bool Application::raycastVoxel(glm::vec3 originInitial, glm::vec3 direction, flo
   float distanceTraveled = 0.0f;
   glm::ivec3 normal(0);
 
+  glm::ivec3 currentSection(std::numeric_limits<int>::min());
+  bool currentSectionEmpty = false;
+
   while (distanceTraveled < maxDistance)
   {
     int axis;
@@ -400,6 +520,16 @@ bool Application::raycastVoxel(glm::vec3 originInitial, glm::vec3 direction, flo
     normal[axis] = -step[axis];
 
     distanceTraveled = glm::length(glm::vec3(pos) - origin);
+
+    glm::ivec3 section = glm::ivec3(glm::floor(pos / glm::vec3(ChunkData::chunkSize, ChunkData::sectionHeight, ChunkData::chunkSize)));
+    if (section != currentSection)
+    {
+      currentSection = section;
+      currentSectionEmpty = world.isSectionEmpty(pos.x, pos.y, pos.z);
+    }
+    if (currentSectionEmpty)
+      continue;
+
     BlockType block = world.getBlock(pos.x, pos.y, pos.z);
     if (block != BlockType::Air && block != BlockType::Nothing && block != BlockType::Water)
     {
@@ -417,9 +547,9 @@ void Application::tryAddChunk(int dx, int dz, glm::ivec3 playerChunk)
 {
   glm::ivec3 chunkPos = playerChunk + glm::ivec3(dx * ChunkData::chunkSize, 0, dz * ChunkData::chunkSize);
 
-  if (!world.chunkLoadQueue.has(chunkPos))
+  if (!world.chunkLoadQueue.has(chunkPos) && world.chunkNeedsUpdate(chunkPos))
   {
-    world.chunkLoadQueue.push(chunkPos);
+    world.queueChunk(chunkPos);
   }
 }
 
@@ -470,6 +600,15 @@ void Application::resolveCollisions(glm::vec3 &position, glm::vec3 &velocity, co
   int z0 = floor(min.z);
   int z1 = floor(max.z);
 
+  // the box is smaller than a section, so its corners touch every section it overlaps
+  bool allSectionsEmpty = true;
+  for (int corner = 0; corner < 8 && allSectionsEmpty; ++corner)
+  {
+    allSectionsEmpty = world.isSectionEmpty((corner & 1) ? x1 : x0, (corner & 2) ? y1 : y0, (corner & 4) ? z1 : z0);
+  }
+  if (allSectionsEmpty)
+    return;
+
   for (int x = x0; x <= x1; ++x)
     for (int y = y0; y <= y1; ++y)
       for (int z = z0; z <= z1; ++z)
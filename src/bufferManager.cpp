@@ -19,6 +19,22 @@ void BufferManager::createUniformBuffers(int MAX_FRAMES_IN_FLIGHT, VkDevice devi
   }
 }
 
+void BufferManager::createVoxelFrameBuffers(int MAX_FRAMES_IN_FLIGHT, VkDevice device, VkPhysicalDevice physicalDevice)
+{
+  VkDeviceSize bufferSize = sizeof(VoxelFrameUniforms);
+
+  voxelFrameBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+  voxelFrameBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+  voxelFrameBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+
+  for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+  {
+    createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, voxelFrameBuffers[i], voxelFrameBuffersMemory[i], device, physicalDevice);
+
+    vkMapMemory(device, voxelFrameBuffersMemory[i], 0, bufferSize, 0, &voxelFrameBuffersMapped[i]);
+  }
+}
+
 void BufferManager::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory, VkDevice device, VkPhysicalDevice physicalDevice)
 {
   VkBufferCreateInfo bufferInfo{};
@@ -74,9 +90,65 @@ void BufferManager::createIndexBuffer(const std::vector<uint32_t> &inputIndices,
   vkFreeMemory(device, stagingBufferMemory, nullptr);
 }
 
+void BufferManager::createQuadIndexBuffer(uint32_t quadCount, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+  if (quadCount <= quadIndexCapacity)
+  {
+    return;
+  }
+
+  std::vector<uint32_t> quadIndices(static_cast<size_t>(quadCount) * 6);
+  for (uint32_t quad = 0; quad < quadCount; quad++)
+  {
+    uint32_t *index = &quadIndices[quad * 6];
+    uint32_t firstVertex = quad * 4;
+    index[0] = firstVertex + 0;
+    index[1] = firstVertex + 1;
+    index[2] = firstVertex + 2;
+    index[3] = firstVertex + 2;
+    index[4] = firstVertex + 3;
+    index[5] = firstVertex + 0;
+  }
+
+  VkDeviceSize bufferSize = sizeof(quadIndices[0]) * quadIndices.size();
+  VkBuffer stagingBuffer;
+  VkDeviceMemory stagingBufferMemory;
+  createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory, device, physicalDevice);
+
+  void *data;
+  vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
+  memcpy(data, quadIndices.data(), (size_t)bufferSize);
+  vkUnmapMemory(device, stagingBufferMemory);
+
+  if (quadIndexBuffer != VK_NULL_HANDLE)
+  {
+    vkQueueWaitIdle(graphicsQueue);
+    vkDestroyBuffer(device, quadIndexBuffer, nullptr);
+    vkFreeMemory(device, quadIndexBufferMemory, nullptr);
+  }
+
+  createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, quadIndexBuffer, quadIndexBufferMemory, device, physicalDevice);
+
+  copyBuffer(stagingBuffer, quadIndexBuffer, bufferSize, device, commandPool, graphicsQueue);
+
+  vkDestroyBuffer(device, stagingBuffer, nullptr);
+  vkFreeMemory(device, stagingBufferMemory, nullptr);
+
+  quadIndexCapacity = quadCount;
+}
+
 void BufferManager::createVertexBuffer(const std::vector<Vertex> &verts, int targetBuffer, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
 {
-  VkDeviceSize bufferSize = sizeof(verts[0]) * verts.size();
+  createVertexBuffer(verts.data(), sizeof(Vertex) * verts.size(), targetBuffer, device, physicalDevice, commandPool, graphicsQueue);
+}
+
+void BufferManager::createVertexBuffer(const std::vector<VoxelVertex> &verts, int targetBuffer, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+  createVertexBuffer(verts.data(), sizeof(VoxelVertex) * verts.size(), targetBuffer, device, physicalDevice, commandPool, graphicsQueue);
+}
+
+void BufferManager::createVertexBuffer(const void *verts, VkDeviceSize bufferSize, int targetBuffer, VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
 
   if (bufferSize == 0)
   {
@@ -97,7 +169,7 @@ void BufferManager::createVertexBuffer(const std::vector<Vertex> &verts, int tar
 
     void *data;
     vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, verts.data(), (size_t)bufferSize);
+    memcpy(data, verts, (size_t)bufferSize);
     vkUnmapMemory(device, stagingBufferMemory);
 
     if (bufferSize > vertexBufferSizes[targetBuffer])
@@ -132,7 +204,7 @@ void BufferManager::createVertexBuffer(const std::vector<Vertex> &verts, int tar
 
   void *data;
   vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, verts.data(), (size_t)bufferSize);
+  memcpy(data, verts, (size_t)bufferSize);
   vkUnmapMemory(device, stagingBufferMemory);
 
   createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBuffers[targetBuffer], vertexBufferMemory[targetBuffer], device, physicalDevice);
@@ -210,6 +282,24 @@ void BufferManager::cleanup(VkDevice device)
     vkFreeMemory(device, uniformBufferMemory, nullptr);
   }
 
+  for (size_t i = 0; i < voxelFrameBuffers.size(); i++)
+  {
+    vkDestroyBuffer(device, voxelFrameBuffers[i], nullptr);
+    vkFreeMemory(device, voxelFrameBuffersMemory[i], nullptr);
+  }
+  voxelFrameBuffers.clear();
+  voxelFrameBuffersMemory.clear();
+  voxelFrameBuffersMapped.clear();
+
+  if (quadIndexBuffer != VK_NULL_HANDLE)
+  {
+    vkDestroyBuffer(device, quadIndexBuffer, nullptr);
+    vkFreeMemory(device, quadIndexBufferMemory, nullptr);
+    quadIndexBuffer = VK_NULL_HANDLE;
+    quadIndexBufferMemory = VK_NULL_HANDLE;
+    quadIndexCapacity = 0;
+  }
+
   for (auto &indexBuffer : indexBuffers)
   {
     if (indexBuffer != VK_NULL_HANDLE)
@@ -258,3 +348,15 @@ void BufferManager::updateUniformBuffer(uint32_t currentImage, glm::mat4 transfo
 
   memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
 }
+
+void BufferManager::updateVoxelFrameBuffer(uint32_t currentImage, glm::mat4 view, glm::mat4 proj, glm::vec3 viewPos)
+{
+  VoxelFrameUniforms frame{};
+
+  frame.view = view;
+  frame.proj = proj;
+  frame.proj[1][1] *= -1;
+  frame.viewPos = glm::vec4(viewPos, 1.0f);
+
+  memcpy(voxelFrameBuffersMapped[currentImage], &frame, sizeof(frame));
+}
@@ -158,6 +158,55 @@ void DescriptorManager::addDescriptorSets(VkDevice device, int MAX_FRAMES_IN_FLI
   descriptorSets.insert(descriptorSets.end(), newDescriptorSets.begin(), newDescriptorSets.end());
 }
 
+void DescriptorManager::createVoxelDescriptorSets(VkDevice device, int MAX_FRAMES_IN_FLIGHT, VkImageView textureImageView, VkSampler textureSampler)
+{
+  std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = descriptorPool;
+  allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+  allocInfo.pSetLayouts = layouts.data();
+
+  voxelDescriptorSets.resize(layouts.size());
+  if (vkAllocateDescriptorSets(device, &allocInfo, voxelDescriptorSets.data()) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to allocate voxel descriptor sets!");
+  }
+
+  for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+  {
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = bufferManager.voxelFrameBuffers[i];
+    bufferInfo.offset = 0;
+    bufferInfo.range = sizeof(VoxelFrameUniforms);
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = textureImageView;
+    imageInfo.sampler = textureSampler;
+
+    std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = voxelDescriptorSets[i];
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].dstArrayElement = 0;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pBufferInfo = &bufferInfo;
+
+    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[1].dstSet = voxelDescriptorSets[i];
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].dstArrayElement = 0;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+  }
+}
+
 void DescriptorManager::cleanup(VkDevice device)
 {
   vkDestroyDescriptorPool(device, descriptorPool, nullptr);
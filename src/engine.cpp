@@ -48,6 +48,8 @@ void Engine::init(std::string windowName, std::function<void(Engine *)> startFn,
   voxelTextureAtlas->createTextureImageView(renderer.deviceManager.device);
 
   voxelTextureAtlas->createTextureSampler(renderer.deviceManager.device, renderer.deviceManager.physicalDevice);
+
+  renderer.descriptorManager.createVoxelDescriptorSets(renderer.deviceManager.device, renderer.MAX_FRAMES_IN_FLIGHT, voxelTextureAtlas->textureImageView, voxelTextureAtlas->textureSampler);
 }
 
 void Engine::run()
@@ -101,9 +103,30 @@ void Engine::render()
   glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
   glm::mat4 staticView = glm::lookAt(cameraPos, cameraTarget, cameraUp);
 
+  renderer.renderQueue.push_back(makeVoxelFrameCommand(&renderer, renderer.getCurrentFrame(), view, proj, camera.Position));
+
+  std::vector<std::pair<float, std::pair<GameObject *, VoxelMesh *>>> translucentList;
   for (auto &[key, gameObject] : gameObjects)
   {
     renderer.renderQueue.push_back(makeGameObjectCommand(gameObject, &renderer, renderer.getCurrentFrame(), view, proj));
+
+    for (auto &mesh : gameObject.translucentVoxelMeshes)
+    {
+      glm::vec3 offset = gameObject.position + mesh.boundsCenter - camera.Position;
+      translucentList.push_back({glm::dot(offset, offset), {&gameObject, &mesh}});
+    }
+  }
+
+  // translucent chunk meshes are blended after every opaque mesh, farthest first
+  std::sort(translucentList.begin(), translucentList.end(),
+            [](const auto &a, const auto &b)
+            {
+              return a.first > b.first;
+            });
+
+  for (auto &[distance, translucent] : translucentList)
+  {
+    renderer.renderQueue.push_back(makeTranslucentCommand(*translucent.first, *translucent.second, &renderer, renderer.getCurrentFrame(), view, proj));
   }
 
   std::vector<std::reference_wrapper<GameObject>> uiList;
@@ -295,18 +318,32 @@ void Engine::addMeshToObject(std::string identifier, MaterialData material, cons
   gameObject.meshes.emplace_back(std::move(mesh));
 }
 
-void Engine::addVoxelMeshToObject(std::string identifier, MaterialData material, const std::string &texturePath, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+void Engine::setVoxelSectionMesh(std::string identifier, int section, MaterialData material, glm::vec2 tileSize, const std::vector<VoxelVertex> &vertices, bool translucent)
 {
   auto it = gameObjects.find(identifier);
   if (it == gameObjects.end())
   {
     return;
   }
-  GameObject &gameObject = it->second;
+  std::vector<VoxelMesh> &meshes = translucent ? it->second.translucentVoxelMeshes : it->second.voxelMeshes;
 
-  Mesh mesh(voxelTextureAtlas, &nextRenderingId, material, vertices, indices);
-  mesh.initGraphics(renderer);
-  gameObject.meshes.emplace_back(std::move(mesh));
+  auto existing = std::find_if(meshes.begin(), meshes.end(), [section](const VoxelMesh &mesh)
+                               { return mesh.section == section; });
+  if (existing != meshes.end())
+  {
+    existing->cleanup(renderer.deviceManager.device, renderer);
+    meshes.erase(existing);
+  }
+
+  if (vertices.empty())
+  {
+    return;
+  }
+
+  VoxelMesh mesh(voxelTextureAtlas, material, tileSize, vertices);
+  mesh.section = section;
+  mesh.initGraphics(renderer, vertices);
+  meshes.emplace_back(std::move(mesh));
 }
 
 void Engine::loadModel(std::string identifier, const std::string objPath, const std::string mtlPath)
@@ -0,0 +1,81 @@
+#include "frameScheduler.hpp"
+#include <iostream>
+#include <algorithm>
+
+void FrameScheduler::schedule(FramePriority priority, Task task)
+{
+  tasks[static_cast<int>(priority)].push_back(std::move(task));
+}
+
+void FrameScheduler::addSource(FramePriority priority, WorkSource source)
+{
+  sources[static_cast<int>(priority)].push_back(std::move(source));
+}
+
+void FrameScheduler::runFrame()
+{
+  Clock::time_point start = Clock::now();
+  auto elapsedMs = [start]()
+  {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+  };
+
+  bool ranAny = false;
+  auto withinBudget = [&]()
+  {
+    return !ranAny || elapsedMs() < budgetMs;
+  };
+
+  for (int priority = 0; priority < static_cast<int>(FramePriority::Count) && withinBudget(); ++priority)
+  {
+    std::deque<Task> &queue = tasks[priority];
+    while (!queue.empty() && withinBudget())
+    {
+      // moved out first, the task may schedule more work
+      Task task = std::move(queue.front());
+      queue.pop_front();
+      task();
+      ranAny = true;
+    }
+
+    for (WorkSource &source : sources[priority])
+    {
+      while (withinBudget() && source())
+      {
+        ranAny = true;
+      }
+    }
+  }
+
+  // ending up to one unit past the budget is expected, only count frames well past it
+  lastFrameMs = elapsedMs();
+  if (lastFrameMs > budgetMs * 1.5f)
+  {
+    reportOverrun(lastFrameMs);
+  }
+}
+
+size_t FrameScheduler::pendingTasks() const
+{
+  size_t count = 0;
+  for (const std::deque<Task> &queue : tasks)
+  {
+    count += queue.size();
+  }
+  return count;
+}
+
+void FrameScheduler::reportOverrun(float frameMs)
+{
+  overrunFrames++;
+  worstOverrunMs = std::max(worstOverrunMs, frameMs);
+
+  Clock::time_point now = Clock::now();
+  if (now - lastReport < std::chrono::seconds(1))
+    return;
+
+  std::cerr << "Frame budget of " << budgetMs << " ms overrun in " << overrunFrames << " frames, worst " << worstOverrunMs << " ms" << std::endl;
+  overrunFrames = 0;
+  worstOverrunMs = 0.0f;
+  lastReport = now;
+}
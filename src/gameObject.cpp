@@ -7,4 +7,12 @@ void GameObject::cleanup(Renderer &renderer)
   {
     mesh.cleanup(renderer.deviceManager.device, renderer);
   }
+  for (auto &mesh : voxelMeshes)
+  {
+    mesh.cleanup(renderer.deviceManager.device, renderer);
+  }
+  for (auto &mesh : translucentVoxelMeshes)
+  {
+    mesh.cleanup(renderer.deviceManager.device, renderer);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "jobSystem.hpp"
+
+namespace
+{
+  thread_local JobSystem *currentSystem = nullptr;
+  thread_local unsigned currentWorker = 0;
+}
+
+JobSystem::~JobSystem()
+{
+  shutdown();
+}
+
+void JobSystem::start(unsigned workerCount)
+{
+  std::unique_lock<std::shared_mutex> lock(stateMutex);
+  if (running)
+    return;
+
+  if (workerCount == 0)
+  {
+    unsigned hardwareThreads = std::thread::hardware_concurrency();
+    workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+  }
+
+  running = true;
+  stopping = false;
+  for (unsigned i = 0; i < workerCount; ++i)
+  {
+    queues.push_back(std::make_unique<WorkerQueue>());
+  }
+  for (unsigned i = 0; i < workerCount; ++i)
+  {
+    workers.emplace_back([this, i]()
+                         { workerLoop(i); });
+  }
+}
+
+void JobSystem::shutdown()
+{
+  {
+    // waits for submits still pushing a job
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    if (!running || stopping)
+      return;
+    std::lock_guard<std::mutex> sleepLock(sleepMutex);
+    stopping = true;
+  }
+  wake.notify_all();
+
+  // the workers leave once the deques are empty, nothing new gets in while stopping is set
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+
+  std::unique_lock<std::shared_mutex> lock(stateMutex);
+  workers.clear();
+  queues.clear();
+  running = false;
+}
+
+bool JobSystem::submit(Job job)
+{
+  std::shared_lock<std::shared_mutex> lock(stateMutex);
+  if (stopping)
+    return false;
+  if (!running)
+  {
+    lock.unlock();
+    job();
+    return true;
+  }
+
+  unsigned index = currentSystem == this ? currentWorker : nextQueue++ % queues.size();
+  {
+    std::lock_guard<std::mutex> queueLock(queues[index]->mtx);
+    queues[index]->jobs.push_back(std::move(job));
+  }
+  queuedJobs++;
+  lock.unlock();
+
+  // a worker that counted itself as sleeping either still sees the job or is woken here
+  if (sleepingWorkers > 0)
+  {
+    std::lock_guard<std::mutex> sleepLock(sleepMutex);
+    wake.notify_one();
+  }
+  return true;
+}
+
+bool JobSystem::takeJob(unsigned index, Job &job)
+{
+  bool found = false;
+  {
+    WorkerQueue &own = *queues[index];
+    std::lock_guard<std::mutex> lock(own.mtx);
+    if (!own.jobs.empty())
+    {
+      job = std::move(own.jobs.back());
+      own.jobs.pop_back();
+      found = true;
+    }
+  }
+
+  for (size_t i = 1; i < queues.size() && !found; ++i)
+  {
+    WorkerQueue &victim = *queues[(index + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mtx);
+    if (!victim.jobs.empty())
+    {
+      job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      found = true;
+    }
+  }
+
+  if (found)
+    queuedJobs--;
+  return found;
+}
+
+void JobSystem::workerLoop(unsigned index)
+{
+  currentSystem = this;
+  currentWorker = index;
+
+  while (true)
+  {
+    Job job;
+    if (takeJob(index, job))
+    {
+      job();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleepingWorkers++;
+    wake.wait(lock, [this]()
+              { return stopping || queuedJobs > 0; });
+    sleepingWorkers--;
+    if (stopping && queuedJobs == 0)
+      return;
+  }
+}
@@ -92,20 +92,26 @@ void Mesh::cleanup(VkDevice device, Renderer &renderer)
   if (renderer.bufferManager.vertexBuffers.size() > id && renderer.bufferManager.vertexBuffers[id] != VK_NULL_HANDLE)
   {
     vkDestroyBuffer(device, renderer.bufferManager.vertexBuffers[id], nullptr);
+    vkFreeMemory(device, renderer.bufferManager.vertexBufferMemory[id], nullptr);
     renderer.bufferManager.vertexBuffers[id] = VK_NULL_HANDLE;
+    renderer.bufferManager.vertexBufferMemory[id] = VK_NULL_HANDLE;
   }
 
   if (renderer.bufferManager.indexBuffers.size() > id && renderer.bufferManager.indexBuffers[id] != VK_NULL_HANDLE)
   {
     vkDestroyBuffer(device, renderer.bufferManager.indexBuffers[id], nullptr);
+    vkFreeMemory(device, renderer.bufferManager.indexBufferMemory[id], nullptr);
     renderer.bufferManager.indexBuffers[id] = VK_NULL_HANDLE;
+    renderer.bufferManager.indexBufferMemory[id] = VK_NULL_HANDLE;
   }
 
   for (int i = 0; i < renderer.MAX_FRAMES_IN_FLIGHT; i++)
   {
     vkDestroyBuffer(device, renderer.bufferManager.uniformBuffers[id * renderer.MAX_FRAMES_IN_FLIGHT + i], nullptr);
+    vkFreeMemory(device, renderer.bufferManager.uniformBuffersMemory[id * renderer.MAX_FRAMES_IN_FLIGHT + i], nullptr);
 
     renderer.bufferManager.uniformBuffers[id * renderer.MAX_FRAMES_IN_FLIGHT + i] = VK_NULL_HANDLE;
+    renderer.bufferManager.uniformBuffersMemory[id * renderer.MAX_FRAMES_IN_FLIGHT + i] = VK_NULL_HANDLE;
   }
 
   uint32_t descriptorSetCount = renderer.MAX_FRAMES_IN_FLIGHT;
@@ -4,7 +4,9 @@
 #include "swapchainManager.hpp"
 #include "descriptorManager.hpp"
 #include "mesh.hpp"
+#include "voxelMesh.hpp"
 #include "vertex.h"
+#include "voxelVertex.h"
 #include <fstream>
 
 void PipelineManager::createRenderPass(VkDevice device, VkPhysicalDevice physicalDevice)
@@ -113,8 +115,38 @@ std::vector<char> PipelineManager::readFile(const std::string &filename)
 
 void PipelineManager::createGraphicsPipeline(VkDevice device)
 {
-  auto vertShaderCode = readFile("shaders/vert.spv");
-  auto fragShaderCode = readFile("shaders/frag.spv");
+  VkVertexInputBindingDescription vertexBinding = Vertex::getBindingDescription();
+  auto vertexAttributes = Vertex::getAttributeDescriptions();
+
+  VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertexInputInfo.vertexBindingDescriptionCount = 1;
+  vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+  vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
+  vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
+
+  createPipeline(device, "shaders/vert.spv", "shaders/frag.spv", vertexInputInfo, sizeof(MaterialData), pipelineLayout, graphicsPipeline);
+}
+
+void PipelineManager::createVoxelPipeline(VkDevice device)
+{
+  VkVertexInputBindingDescription vertexBinding = VoxelVertex::getBindingDescription();
+  auto vertexAttributes = VoxelVertex::getAttributeDescriptions();
+
+  VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertexInputInfo.vertexBindingDescriptionCount = 1;
+  vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+  vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
+  vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
+
+  createPipeline(device, "shaders/voxelVert.spv", "shaders/voxelFrag.spv", vertexInputInfo, sizeof(VoxelPushConstants), voxelPipelineLayout, voxelPipeline);
+}
+
+void PipelineManager::createPipeline(VkDevice device, const std::string &vertShaderPath, const std::string &fragShaderPath, const VkPipelineVertexInputStateCreateInfo &vertexInputInfo, uint32_t pushConstantSize, VkPipelineLayout &layout, VkPipeline &pipeline)
+{
+  auto vertShaderCode = readFile(vertShaderPath);
+  auto fragShaderCode = readFile(fragShaderPath);
 
   VkShaderModule vertShaderModule = createShaderModule(vertShaderCode, device);
   VkShaderModule fragShaderModule = createShaderModule(fragShaderCode, device);
@@ -147,16 +179,6 @@ void PipelineManager::createGraphicsPipeline(VkDevice device)
   dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
   dynamicState.pDynamicStates = dynamicStates.data();
 
-  VkVertexInputBindingDescription vertexBinding = Vertex::getBindingDescription();
-  auto vertexAttributes = Vertex::getAttributeDescriptions();
-
-  VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertexInputInfo.vertexBindingDescriptionCount = 1;
-  vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
-  vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
-  vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
-
   VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
   inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
   inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -213,7 +235,7 @@ void PipelineManager::createGraphicsPipeline(VkDevice device)
   VkPushConstantRange pushConstantRange{};
   pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
   pushConstantRange.offset = 0;
-  pushConstantRange.size = sizeof(MaterialData);
+  pushConstantRange.size = pushConstantSize;
 
   VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -222,7 +244,7 @@ void PipelineManager::createGraphicsPipeline(VkDevice device)
   pipelineLayoutInfo.pushConstantRangeCount = 1;
   pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
-  if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+  if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS)
   {
     throw std::runtime_error("failed to create pipeline layout!");
   }
@@ -243,7 +265,7 @@ void PipelineManager::createGraphicsPipeline(VkDevice device)
   pipelineInfo.pDynamicState = &dynamicState;
   pipelineInfo.pDepthStencilState = &depthStencil;
 
-  pipelineInfo.layout = pipelineLayout;
+  pipelineInfo.layout = layout;
 
   pipelineInfo.renderPass = renderPass;
   pipelineInfo.subpass = 0;
@@ -251,7 +273,7 @@ void PipelineManager::createGraphicsPipeline(VkDevice device)
   pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
   pipelineInfo.basePipelineIndex;
 
-  if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+  if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
   {
     throw std::runtime_error("failed to create graphics pipeline!");
   }
@@ -262,6 +284,8 @@ void PipelineManager::createGraphicsPipeline(VkDevice device)
 
 void PipelineManager::cleanup(VkDevice device)
 {
+  vkDestroyPipeline(device, voxelPipeline, nullptr);
+  vkDestroyPipelineLayout(device, voxelPipelineLayout, nullptr);
   vkDestroyPipeline(device, graphicsPipeline, nullptr);
   vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
   vkDestroyRenderPass(device, renderPass, nullptr);
@@ -135,6 +135,16 @@ void disableDepthWrite(Renderer *renderer, VkCommandBuffer commandBuffer)
   }
 }
 
+// fills the camera block every voxel mesh reads this frame, runs after the frame's fence so the buffer is free
+RenderCommand makeVoxelFrameCommand(Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj, glm::vec3 viewPos)
+{
+  return {
+      [renderer, currentFrame, view, proj, viewPos](VkCommandBuffer cmdBuf)
+      {
+        renderer->bufferManager.updateVoxelFrameBuffer(currentFrame, view, proj, viewPos);
+      }};
+}
+
 RenderCommand makeGameObjectCommand(GameObject &gameObject, Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj)
 {
   return {
@@ -158,6 +168,30 @@ RenderCommand makeGameObjectCommand(GameObject &gameObject, Renderer *renderer,
         {
           mesh.draw(renderer, currentFrame, transformation, view, proj, cmdBuf);
         }
+
+        if (!gameObject.voxelMeshes.empty())
+        {
+          vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->pipelineManager.voxelPipeline);
+          for (auto &mesh : gameObject.voxelMeshes)
+          {
+            mesh.draw(renderer, currentFrame, gameObject.position, cmdBuf);
+          }
+        }
+      }};
+}
+
+RenderCommand makeTranslucentCommand(GameObject &gameObject, VoxelMesh &mesh, Renderer *renderer, int currentFrame, glm::mat4 view, glm::mat4 proj)
+{
+  return {
+      [renderer, &gameObject, &mesh, currentFrame](VkCommandBuffer cmdBuf)
+      {
+        vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->pipelineManager.voxelPipeline);
+        setTriangleTopology(renderer, cmdBuf);
+        disableDepthWrite(renderer, cmdBuf);
+
+        setupViewportScissor(renderer, cmdBuf);
+
+        mesh.draw(renderer, currentFrame, gameObject.position, cmdBuf);
       }};
 }
 
@@ -29,6 +29,7 @@ void Renderer::initVulkan()
   pipelineManager.createRenderPass(deviceManager.device, deviceManager.physicalDevice);
   descriptorManager.createDescriptorSetLayout(deviceManager.device);
   pipelineManager.createGraphicsPipeline(deviceManager.device);
+  pipelineManager.createVoxelPipeline(deviceManager.device);
   createCommandPool();
   swapchainManager.createDepthResources(deviceManager.device, deviceManager.physicalDevice, commandPool, graphicsQueue);
   swapchainManager.createFramebuffers(deviceManager.device, pipelineManager.renderPass);
@@ -36,7 +37,11 @@ void Renderer::initVulkan()
   // bufferManager.createVertexBuffer(vertices, 0, deviceManager.device, deviceManager.physicalDevice, commandPool, graphicsQueue);
   // bufferManager.createIndexBuffer(indices, 0, deviceManager.device, deviceManager.physicalDevice, commandPool, //graphicsQueue);
   // bufferManager.createUniformBuffers(MAX_FRAMES_IN_FLIGHT, deviceManager.device, deviceManager.physicalDevice, 2);
+  // models, text and debug lines take a set per frame in flight each, chunk meshes all share voxelDescriptorSets
   descriptorManager.createDescriptorPool(deviceManager.device, MAX_FRAMES_IN_FLIGHT, 2000);
+  bufferManager.createQuadIndexBuffer(INITIAL_QUAD_INDEX_CAPACITY, deviceManager.device, deviceManager.physicalDevice, commandPool, graphicsQueue);
+  bufferManager.createVoxelFrameBuffers(MAX_FRAMES_IN_FLIGHT, deviceManager.device, deviceManager.physicalDevice);
+  voxelArena.init(deviceManager.device, deviceManager.physicalDevice, MAX_FRAMES_IN_FLIGHT);
 
   // descriptorManager.createDescriptorSets(deviceManager.device, MAX_FRAMES_IN_FLIGHT, 1);
   // descriptorManager.addDescriptorSets(deviceManager.device, MAX_FRAMES_IN_FLIGHT, 1);
@@ -170,6 +175,9 @@ void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t image
 {
   beginCommandBuffer(commandBuffer, imageIndex);
 
+  // section vertices staged since the last frame are copied before anything draws them
+  voxelArena.flushUploads(commandBuffer, frameNumber);
+
   beginRenderPass(commandBuffer, imageIndex);
 
   vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineManager.graphicsPipeline);
@@ -203,6 +211,7 @@ void Renderer::drawFrame()
 {
 
   vkWaitForFences(deviceManager.device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+  voxelArena.collect(frameNumber);
 
   uint32_t imageIndex;
   VkResult result = vkAcquireNextImageKHR(deviceManager.device, swapchainManager.swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -244,6 +253,7 @@ void Renderer::drawFrame()
   {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
+  frameNumber++;
 
   VkPresentInfoKHR presentInfo{};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -277,12 +287,18 @@ uint32_t Renderer::getCurrentFrame()
   return currentFrame;
 }
 
+uint64_t Renderer::getFrameNumber()
+{
+  return frameNumber;
+}
+
 void Renderer::cleanup()
 {
   swapchainManager.cleanupDepthImages(deviceManager.device);
   swapchainManager.cleanupSwapChain(deviceManager.device);
 
   bufferManager.cleanup(deviceManager.device);
+  voxelArena.cleanup();
 
   descriptorManager.cleanup(deviceManager.device);
 
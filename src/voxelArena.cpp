@@ -0,0 +1,315 @@
+#include "voxelArena.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+void VoxelArena::init(VkDevice device, VkPhysicalDevice physicalDevice, int framesInFlight)
+{
+  this->device = device;
+  this->physicalDevice = physicalDevice;
+  this->framesInFlight = framesInFlight;
+  createPage(pageSize);
+}
+
+bool VoxelArena::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &memory)
+{
+  VkBufferCreateInfo bufferInfo{};
+  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferInfo.size = size;
+  bufferInfo.usage = usage;
+  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+  {
+    throw std::runtime_error("failed to create voxel arena buffer!");
+  }
+
+  VkMemoryRequirements memRequirements;
+  vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+  // unlike findMemoryType a missing or exhausted memory type is not fatal, the caller picks another
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+  {
+    if (!(memRequirements.memoryTypeBits & (1 << i)) || (memProperties.memoryTypes[i].propertyFlags & properties) != properties)
+    {
+      continue;
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = i;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) == VK_SUCCESS)
+    {
+      vkBindBufferMemory(device, buffer, memory, 0);
+      return true;
+    }
+  }
+
+  vkDestroyBuffer(device, buffer, nullptr);
+  buffer = VK_NULL_HANDLE;
+  return false;
+}
+
+int VoxelArena::createPage(VkDeviceSize capacity)
+{
+  int index = -1;
+  for (size_t i = 0; i < pages.size(); i++)
+  {
+    if (pages[i].buffer == VK_NULL_HANDLE)
+    {
+      index = static_cast<int>(i);
+      break;
+    }
+  }
+  if (index == -1)
+  {
+    index = static_cast<int>(pages.size());
+    pages.emplace_back();
+  }
+  Page &page = pages[index];
+
+  // vertices are read every frame, so pages live in device local memory. Mapping it saves the
+  // staging copy, but without resizable BAR that memory is a small heap and may run out
+  VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  if (createBuffer(capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, page.buffer, page.memory))
+  {
+    void *mapped;
+    vkMapMemory(device, page.memory, 0, capacity, 0, &mapped);
+    page.mapped = static_cast<char *>(mapped);
+  }
+  else if (!createBuffer(capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, page.buffer, page.memory))
+  {
+    throw std::runtime_error("failed to allocate voxel arena memory!");
+  }
+
+  page.capacity = capacity;
+  page.freeRanges.clear();
+  page.freeRanges[0] = capacity;
+  return index;
+}
+
+int VoxelArena::stagingFor(VkDeviceSize size)
+{
+  // the staging buffer being filled for the next flush, or an idle one
+  int idle = -1;
+  for (size_t i = 0; i < stagings.size(); i++)
+  {
+    Staging &staging = stagings[i];
+    if (staging.inFlight || staging.capacity - staging.used < size)
+    {
+      continue;
+    }
+    if (staging.used > 0)
+    {
+      return static_cast<int>(i);
+    }
+    if (idle == -1)
+    {
+      idle = static_cast<int>(i);
+    }
+  }
+  if (idle != -1)
+  {
+    return idle;
+  }
+
+  Staging staging;
+  staging.capacity = std::max(stagingSize, size);
+  if (!createBuffer(staging.capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, staging.memory))
+  {
+    throw std::runtime_error("failed to allocate voxel staging memory!");
+  }
+  void *mapped;
+  vkMapMemory(device, staging.memory, 0, staging.capacity, 0, &mapped);
+  staging.mapped = static_cast<char *>(mapped);
+  stagings.push_back(staging);
+  return static_cast<int>(stagings.size() - 1);
+}
+
+void VoxelArena::destroyPage(Page &page)
+{
+  if (page.buffer == VK_NULL_HANDLE)
+  {
+    return;
+  }
+  if (page.mapped)
+  {
+    vkUnmapMemory(device, page.memory);
+  }
+  vkDestroyBuffer(device, page.buffer, nullptr);
+  vkFreeMemory(device, page.memory, nullptr);
+  page = Page();
+}
+
+VoxelAllocation VoxelArena::allocate(const void *data, VkDeviceSize size)
+{
+  VoxelAllocation allocation;
+  if (size == 0)
+  {
+    return allocation;
+  }
+  VkDeviceSize alignedSize = (size + granularity - 1) / granularity * granularity;
+
+  // first fit over the existing pages, a new page only when none has room
+  for (size_t i = 0; i < pages.size() && allocation.page == -1; i++)
+  {
+    for (auto &[offset, rangeSize] : pages[i].freeRanges)
+    {
+      if (rangeSize >= alignedSize)
+      {
+        allocation.page = static_cast<int>(i);
+        allocation.offset = offset;
+        break;
+      }
+    }
+  }
+  if (allocation.page == -1)
+  {
+    allocation.page = createPage(std::max(pageSize, alignedSize));
+    allocation.offset = 0;
+  }
+  allocation.size = alignedSize;
+
+  Page &page = pages[allocation.page];
+  auto range = page.freeRanges.find(allocation.offset);
+  VkDeviceSize remaining = range->second - alignedSize;
+  page.freeRanges.erase(range);
+  if (remaining > 0)
+  {
+    page.freeRanges[allocation.offset + alignedSize] = remaining;
+  }
+
+  if (page.mapped)
+  {
+    memcpy(page.mapped + allocation.offset, data, static_cast<size_t>(size));
+  }
+  else
+  {
+    int stagingIndex = stagingFor(alignedSize);
+    Staging &staging = stagings[stagingIndex];
+    memcpy(staging.mapped + staging.used, data, static_cast<size_t>(size));
+    uploads.push_back({stagingIndex, allocation.page, {staging.used, allocation.offset, size}});
+    staging.used += alignedSize;
+  }
+  used += alignedSize;
+  return allocation;
+}
+
+void VoxelArena::flushUploads(VkCommandBuffer commandBuffer, uint64_t frameNumber)
+{
+  if (uploads.empty())
+  {
+    return;
+  }
+
+  for (const Upload &upload : uploads)
+  {
+    vkCmdCopyBuffer(commandBuffer, stagings[upload.staging].buffer, pages[upload.page].buffer, 1, &upload.region);
+  }
+  uploads.clear();
+
+  for (Staging &staging : stagings)
+  {
+    if (!staging.inFlight && staging.used > 0)
+    {
+      staging.inFlight = true;
+      staging.frameNumber = frameNumber;
+    }
+  }
+
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void VoxelArena::release(const VoxelAllocation &allocation, uint64_t frameNumber)
+{
+  if (allocation.page == -1)
+  {
+    return;
+  }
+  retired.push_back({allocation, frameNumber});
+}
+
+void VoxelArena::collect(uint64_t frameNumber)
+{
+  size_t kept = 0;
+  for (size_t i = 0; i < retired.size(); i++)
+  {
+    if (retired[i].frameNumber + framesInFlight <= frameNumber)
+    {
+      freeRange(retired[i].allocation);
+    }
+    else
+    {
+      retired[kept++] = retired[i];
+    }
+  }
+  retired.resize(kept);
+
+  for (Staging &staging : stagings)
+  {
+    if (staging.inFlight && staging.frameNumber + framesInFlight <= frameNumber)
+    {
+      staging.inFlight = false;
+      staging.used = 0;
+    }
+  }
+}
+
+void VoxelArena::freeRange(const VoxelAllocation &allocation)
+{
+  Page &page = pages[allocation.page];
+  used -= allocation.size;
+
+  VkDeviceSize offset = allocation.offset;
+  VkDeviceSize size = allocation.size;
+  auto next = page.freeRanges.lower_bound(offset);
+  if (next != page.freeRanges.end() && offset + size == next->first)
+  {
+    size += next->second;
+    next = page.freeRanges.erase(next);
+  }
+  if (next != page.freeRanges.begin())
+  {
+    auto previous = std::prev(next);
+    if (previous->first + previous->second == offset)
+    {
+      offset = previous->first;
+      size += previous->second;
+      page.freeRanges.erase(previous);
+    }
+  }
+  page.freeRanges[offset] = size;
+
+  // the first page stays around, later ones go back to the driver once empty
+  if (allocation.page > 0 && size == page.capacity)
+  {
+    destroyPage(page);
+  }
+}
+
+void VoxelArena::cleanup()
+{
+  for (Page &page : pages)
+  {
+    destroyPage(page);
+  }
+  pages.clear();
+  for (Staging &staging : stagings)
+  {
+    vkUnmapMemory(device, staging.memory);
+    vkDestroyBuffer(device, staging.buffer, nullptr);
+    vkFreeMemory(device, staging.memory, nullptr);
+  }
+  stagings.clear();
+  uploads.clear();
+  retired.clear();
+  used = 0;
+}
@@ -0,0 +1,59 @@
+#include "voxelMesh.hpp"
+#include "bufferManager.hpp"
+#include "descriptorManager.hpp"
+#include "textureManager.hpp"
+#include "renderer.hpp"
+#include <vulkan/vulkan.h>
+
+VoxelMesh::VoxelMesh(std::shared_ptr<TextureManager> textureManager, MaterialData newMaterial, glm::vec2 tileSize, const std::vector<VoxelVertex> &vertices, bool retainVertices) : quadCount(static_cast<uint32_t>(vertices.size() / 4)), material(newMaterial), tileSize(tileSize), textureManager(textureManager)
+{
+  glm::ivec3 boundsMin(INT32_MAX);
+  glm::ivec3 boundsMax(INT32_MIN);
+  for (const VoxelVertex &vertex : vertices)
+  {
+    boundsMin = glm::min(boundsMin, vertex.getPosition());
+    boundsMax = glm::max(boundsMax, vertex.getPosition());
+  }
+  boundsCenter = vertices.empty() ? glm::vec3(0.0f) : glm::vec3(boundsMin + boundsMax) * 0.5f;
+
+  if (retainVertices)
+  {
+    this->vertices = vertices;
+  }
+}
+
+void VoxelMesh::initGraphics(Renderer &renderer, const std::vector<VoxelVertex> &vertices)
+{
+  allocation = renderer.voxelArena.allocate(vertices.data(), sizeof(VoxelVertex) * vertices.size());
+
+  // indices come from the renderer's shared quad index buffer, grown here if this mesh outsizes it
+  renderer.bufferManager.createQuadIndexBuffer(quadCount, renderer.deviceManager.device, renderer.deviceManager.physicalDevice, renderer.commandPool, renderer.graphicsQueue);
+}
+
+void VoxelMesh::draw(Renderer *renderer, int currentFrame, glm::vec3 origin, VkCommandBuffer commandBuffer)
+{
+  VkBuffer vertexBuffersArray[] = {renderer->voxelArena.buffer(allocation.page)};
+  VkDeviceSize offsets[] = {allocation.offset};
+  vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffersArray, offsets);
+
+  vkCmdBindIndexBuffer(commandBuffer, renderer->bufferManager.quadIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->pipelineManager.voxelPipelineLayout, 0, 1, &renderer->descriptorManager.voxelDescriptorSets[currentFrame], 0, nullptr);
+
+  VoxelPushConstants pushConstants{material, tileSize, origin};
+  vkCmdPushConstants(
+      commandBuffer,
+      renderer->pipelineManager.voxelPipelineLayout,
+      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+      0,
+      sizeof(VoxelPushConstants),
+      &pushConstants);
+
+  vkCmdDrawIndexed(commandBuffer, quadCount * 6, 1, 0, 0, 0);
+}
+
+void VoxelMesh::cleanup(VkDevice device, Renderer &renderer)
+{
+  renderer.voxelArena.release(allocation, renderer.getFrameNumber());
+  allocation = VoxelAllocation();
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#include "engine.hpp"
+
+// the world only hands finished meshes to the engine, the tests and benchmarks run without a renderer
+void Engine::createGameObject(std::string, glm::vec3, glm::vec3, glm::vec3)
+{
+}
+
+void Engine::setVoxelSectionMesh(std::string, int, MaterialData, glm::vec2, const std::vector<VoxelVertex> &, bool)
+{
+}
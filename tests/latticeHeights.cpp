@@ -0,0 +1,69 @@
+#include "world.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+// The terrain parameters are interpolated from a lattice every World::parameterLatticeSpacing blocks
+// instead of being sampled per column. Compared with spacing 1 (exact sampling), the default spacing of
+// 4 may move a column's terrain surface by at most maxHeightError blocks, and may move at most
+// maxChangedColumns of all columns.
+static const int maxHeightError = 2;
+static const double maxChangedColumns = 0.02;
+
+static const WorldSeed seeds[] = {0, 42};
+static const int gridSize = 12;
+// errors of the fine height octaves grow with the distance to the noise origin, so a farther area is checked too.
+// Tens of thousands of blocks out the per column height scale turns the terrain itself into noise, any
+// change of the parameters moves single columns there
+static const glm::ivec3 gridCenters[] = {{0, 0, 0}, {4096, 0, -8192}};
+
+// topmost ground block of a column, trees and water are placed on top of it
+static int terrainHeight(const ChunkData &chunk, int x, int z)
+{
+  for (int y = ChunkData::chunkHeight - 1; y >= 0; --y)
+  {
+    BlockType block = chunk.getBlock(x, y, z);
+    if (block == BlockType::Grass_Dirt || block == BlockType::Dirt || block == BlockType::Stone || block == BlockType::Sand)
+      return y;
+  }
+  return -1;
+}
+
+int main()
+{
+  int maxError = 0;
+  long errorSum = 0;
+  long changedColumns = 0;
+  long columns = 0;
+  for (WorldSeed seed : seeds)
+  {
+    World exact(seed, "", 1);
+    World lattice(seed, "", 4);
+
+    // spread over several periods of the slowest field, chunks a few hundred blocks apart
+    for (const glm::ivec3 &center : gridCenters)
+      for (int i = 0; i < gridSize; ++i)
+        for (int j = 0; j < gridSize; ++j)
+        {
+          glm::ivec3 chunkPos = center + glm::ivec3((i - gridSize / 2) * 16 * 9, 0, (j - gridSize / 2) * 16 * 11);
+          exact.generateChunk(chunkPos);
+          lattice.generateChunk(chunkPos);
+          const ChunkData &exactChunk = *exact.chunks.at(chunkPos);
+          const ChunkData &latticeChunk = *lattice.chunks.at(chunkPos);
+          for (int x = 0; x < ChunkData::chunkSize; ++x)
+            for (int z = 0; z < ChunkData::chunkSize; ++z)
+            {
+              int error = std::abs(terrainHeight(latticeChunk, x, z) - terrainHeight(exactChunk, x, z));
+              maxError = std::max(maxError, error);
+              errorSum += error;
+              changedColumns += error != 0;
+              columns++;
+            }
+        }
+  }
+
+  double changed = double(changedColumns) / columns;
+  std::printf("spacing 4 against 1 over %ld columns: max height error %d (allowed %d), mean %.4f, %.2f%% of columns changed (allowed %.2f%%)\n", columns, maxError, maxHeightError,
+              double(errorSum) / columns, 100.0 * changed, 100.0 * maxChangedColumns);
+  return maxError <= maxHeightError && changed <= maxChangedColumns ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#include "world.hpp"
+#include "meshGenerator.hpp"
+#include <cstdio>
+#include <random>
+#include <set>
+#include <tuple>
+
+// Greedy and binary meshing only merge faces, they never add, drop or retexture one. Every quad is
+// expanded back into the unit block faces it covers, keyed by direction, block, tile, corner occlusion and
+// mesh, and the sets have to match what the naive mesher produces one face at a time.
+typedef std::tuple<int, int, int, int, int, int, bool> UnitFace;
+
+struct Coverage
+{
+  std::set<UnitFace> faces;
+  size_t quads = 0;
+  int errors = 0;
+};
+
+static void addCoverage(const std::vector<VoxelVertex> &vertices, bool translucent, Coverage &coverage)
+{
+  for (size_t quad = 0; quad + 3 < vertices.size(); quad += 4)
+  {
+    glm::ivec3 low(1 << 10), high(-1);
+    int ambientOcclusion = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      const VoxelVertex &vertex = vertices[quad + i];
+      low = glm::min(low, vertex.getPosition());
+      high = glm::max(high, vertex.getPosition());
+      ambientOcclusion |= vertex.getAmbientOcclusion() << (vertex.getCorner() * 2);
+    }
+
+    const VoxelVertex &first = vertices[quad];
+    int face = first.getFace();
+    int axis = face / 2;
+    // corners sit on the block boundary, a face pointing along +axis belongs to the block below it
+    if (directions[face][axis] > 0)
+      low[axis]--;
+    high[axis] = low[axis] + 1;
+
+    glm::ivec2 repeatCount = first.getRepeatCount();
+    if (repeatCount.x != high[faceUAxis[axis]] - low[faceUAxis[axis]] || repeatCount.y != high[faceVAxis[axis]] - low[faceVAxis[axis]])
+      coverage.errors++;
+
+    for (int x = low.x; x < high.x; ++x)
+      for (int y = low.y; y < high.y; ++y)
+        for (int z = low.z; z < high.z; ++z)
+        {
+          if (!coverage.faces.insert(UnitFace(face, x, y, z, first.getTileIndex(), ambientOcclusion, translucent)).second)
+            coverage.errors++;
+        }
+    coverage.quads++;
+  }
+}
+
+static Coverage meshCoverage(const ChunkNeighborhood &blocks, BlockDataSO &textureData, MeshingMode mode)
+{
+  MeshGenerator generator;
+  generator.meshingMode = mode;
+  generator.generateMesh(blocks, textureData);
+
+  Coverage coverage;
+  for (const SectionMeshData &section : generator.sectionMeshes)
+  {
+    addCoverage(section.vertices, false, coverage);
+    addCoverage(section.translucentVertices, true, coverage);
+  }
+  return coverage;
+}
+
+// fills the chunk and its border, sections of the chunk that only hold air stay marked empty
+template <typename BlockAt>
+static void fillNeighborhood(ChunkNeighborhood &neighborhood, BlockAt blockAt)
+{
+  neighborhood.clear(glm::ivec3(0));
+  for (int x = -1; x <= ChunkData::chunkSize; ++x)
+    for (int z = -1; z <= ChunkData::chunkSize; ++z)
+      for (int y = 0; y < ChunkData::chunkHeight; ++y)
+      {
+        BlockType block = blockAt(x, y, z);
+        neighborhood.blocks[neighborhood.toIndex(x, y, z)] = block;
+        bool inside = x >= 0 && x < ChunkData::chunkSize && z >= 0 && z < ChunkData::chunkSize;
+        if (inside && block != BlockType::Air && block != BlockType::Nothing)
+          neighborhood.sectionEmpty[y / ChunkData::sectionHeight] = false;
+      }
+}
+
+int main()
+{
+  World world;
+  ChunkNeighborhood neighborhood;
+  int failures = 0;
+
+  auto check = [&](const char *name)
+  {
+    Coverage naive = meshCoverage(neighborhood, world.textureDataSource, MeshingMode::Naive);
+    const MeshingMode merged[] = {MeshingMode::Greedy, MeshingMode::Binary};
+    const char *mergedNames[] = {"greedy", "binary"};
+    for (int i = 0; i < 2; ++i)
+    {
+      Coverage coverage = meshCoverage(neighborhood, world.textureDataSource, merged[i]);
+      bool match = naive.errors == 0 && coverage.errors == 0 && coverage.faces == naive.faces;
+      std::printf("%-12s %s: %zu faces in %zu quads, naive %zu faces%s\n", name, mergedNames[i], coverage.faces.size(), coverage.quads, naive.faces.size(), match ? "" : "  MISMATCH");
+      failures += match ? 0 : 1;
+    }
+  };
+
+  // every block type scattered over three sections and the border, the worst case for merging
+  std::mt19937 random(1234);
+  fillNeighborhood(neighborhood, [&](int, int y, int)
+                   {
+                     if (y < 8 || y >= 56)
+                       return BlockType::Air;
+                     int roll = static_cast<int>(random() % 10);
+                     return roll < 4 ? BlockType::Air : BlockType(roll - 2);
+                   });
+  check("random");
+
+  // stepped hills crossing section boundaries, with dirt under grass and stone further down
+  fillNeighborhood(neighborhood, [](int x, int y, int z)
+                   {
+                     int height = 60 + 3 * ((x + 2 * z + 40) / 5) % 22;
+                     if (y > height)
+                       return BlockType::Air;
+                     if (y == height)
+                       return BlockType::Grass_Dirt;
+                     return y > height - 3 ? BlockType::Dirt : BlockType::Stone;
+                   });
+  check("terraced");
+
+  // a lake running into the +x neighbor with a sand shore, the -z neighbor is not loaded
+  fillNeighborhood(neighborhood, [](int x, int y, int z)
+                   {
+                     if (z < 0)
+                       return BlockType::Nothing;
+                     int distance = (x - 12) * (x - 12) + (z - 6) * (z - 6);
+                     int ground = distance < 30 ? 59 : (distance < 50 ? 62 : 64);
+                     if (y <= ground)
+                       return ground == 64 ? BlockType::Grass_Dirt : BlockType::Sand;
+                     return y <= 63 ? BlockType::Water : BlockType::Air;
+                   });
+  check("water edges");
+
+  return failures == 0 ? 0 : 1;
+}
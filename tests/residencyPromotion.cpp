@@ -0,0 +1,68 @@
+#include "chunkResidency.hpp"
+#include "world.hpp"
+#include <cstdio>
+
+// An unloaded chunk lost its mesh, so whatever the warm tier hands back has to be remeshed whole,
+// whether it was promoted before or after its compress job ran.
+static bool sameBlocks(const ChunkData &a, const ChunkData &b)
+{
+  for (int x = 0; x < ChunkData::chunkSize; ++x)
+    for (int z = 0; z < ChunkData::chunkSize; ++z)
+      for (int y = 0; y < ChunkData::chunkHeight; ++y)
+        if (a.getBlock(x, y, z) != b.getBlock(x, y, z))
+          return false;
+  return true;
+}
+
+static int check(const char *name, bool compressFirst)
+{
+  World world(42);
+  glm::ivec3 chunkPos(-16, 0, 48);
+  world.generateChunk(chunkPos);
+  const ChunkData &generated = *world.chunks.at(chunkPos);
+
+  // the chunk was meshed before it was unloaded
+  auto unloaded = std::make_shared<ChunkData>(generated);
+  unloaded->dirtySections = 0;
+
+  ChunkResidency residency;
+  residency.demote(chunkPos, unloaded);
+  if (compressFirst)
+    residency.compress(chunkPos, unloaded);
+  std::shared_ptr<ChunkData> promoted = residency.promote(chunkPos);
+
+  int failures = 0;
+  if (!promoted)
+  {
+    std::printf("%s: chunk was not promoted\n", name);
+    return 1;
+  }
+  if (promoted == unloaded)
+  {
+    std::printf("%s: promote returned the demoted chunk instead of a copy\n", name);
+    failures++;
+  }
+  if (promoted->dirtySections != ChunkData::allSections)
+  {
+    std::printf("%s: dirty sections %04x, expected %04x\n", name, promoted->dirtySections, ChunkData::allSections);
+    failures++;
+  }
+  if (!sameBlocks(*promoted, generated))
+  {
+    std::printf("%s: blocks differ from the unloaded chunk\n", name);
+    failures++;
+  }
+  if (residency.promote(chunkPos))
+  {
+    std::printf("%s: chunk is still in the warm tier after promotion\n", name);
+    failures++;
+  }
+  return failures;
+}
+
+int main()
+{
+  int failures = check("promoted before compress", false) + check("promoted after compress", true);
+  std::printf("%s\n", failures == 0 ? "promoted chunks are remeshed" : "promotion failed");
+  return failures == 0 ? 0 : 1;
+}